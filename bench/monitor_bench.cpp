@@ -0,0 +1,447 @@
+/*
+Micro and macro benchmarks of LinuxParser and System.
+
+Every case is timed against the live /proc and against a synthetic tree
+written by Fixture::Generate, and reports per operation:
+  ns        wall time
+  allocs    calls to operator new
+  syscalls  system calls, counted with the raw_syscalls:sys_enter
+            tracepoint when perf allows it, else approximated with the
+            read/write syscall counters of /proc/self/io (syscr + syscw)
+Results are printed as one JSON object per line (or CSV) so runs of two
+commits can be diffed or loaded by a script.
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <linux/perf_event.h>
+#include <new>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "collector.h"
+#include "fixture.h"
+#include "linux_parser.h"
+#include "player.h"
+#include "recorder.h"
+#include "stat_parser.h"
+#include "system.h"
+
+namespace {
+std::atomic<std::uint64_t> allocations{0};
+} // namespace
+
+// Count every allocation of the process
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+struct Options_t {
+  std::size_t fixtureProcesses = 10000;
+  unsigned workers = 1;
+  long minTimeMs = 200;
+  bool csv = false;
+  std::string filter;
+  std::string fixtureRoot; // generated in a temporary directory if empty
+  bool checkRecording = false; // only run checkRecording()
+};
+
+struct Result_t {
+  std::string name;
+  std::string tree;
+  std::uint64_t iterations;
+  double ns;
+  double allocs;
+  double syscalls;
+};
+
+/*
+Counts the syscalls of the process: the counter is inherited by the
+threads created after it (scan pool workers), like the /proc/self/io
+fallback which is per process too
+*/
+class SyscallCounter {
+public:
+  SyscallCounter() {
+    std::ifstream idFile(
+        "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id");
+    long id = -1;
+    if (!(idFile >> id)) {
+      std::ifstream debugIdFile(
+          "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id");
+      debugIdFile >> id;
+    }
+    if (id >= 0) {
+      perf_event_attr attr{};
+      attr.type = PERF_TYPE_TRACEPOINT;
+      attr.size = sizeof(attr);
+      attr.config = id;
+      attr.disabled = 0;
+      attr.exclude_hv = 1;
+      attr.inherit = 1;
+      fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+  }
+  ~SyscallCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+  const char *Source() const {
+    return fd_ >= 0 ? "tracepoint" : "syscr+syscw";
+  }
+  std::uint64_t Read() const {
+    if (fd_ >= 0) {
+      std::uint64_t count = 0;
+      if (read(fd_, &count, sizeof(count)) == sizeof(count)) {
+        return count;
+      }
+      return 0;
+    }
+    /* Threads of the scan pool are included: /proc/self/io is per process */
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    std::uint64_t value = 0, total = 0;
+    while (io >> key >> value) {
+      if (key == "syscr:" || key == "syscw:") {
+        total += value;
+      }
+    }
+    return total;
+  }
+
+private:
+  int fd_{-1};
+};
+
+class Bench {
+public:
+  explicit Bench(const Options_t &options) : options_(options) {}
+
+  const SyscallCounter &Counter() const { return counter_; }
+
+  void Run(const std::string &tree, const std::string &name,
+           const std::function<void()> &operation) {
+    if (!options_.filter.empty() &&
+        name.find(options_.filter) == std::string::npos) {
+      return;
+    }
+    using std::chrono::steady_clock;
+
+    /* Warm up caches (UserCache, StringPool, page cache) */
+    for (int i = 0; i < 3; i++) {
+      operation();
+    }
+
+    auto minTime = std::chrono::milliseconds(options_.minTimeMs);
+    std::uint64_t iterations = 0;
+    std::uint64_t batch = 1;
+    std::uint64_t allocs = allocations.load();
+    std::uint64_t syscalls = counter_.Read();
+    auto start = steady_clock::now();
+    auto now = start;
+    while (now - start < minTime) {
+      for (std::uint64_t i = 0; i < batch; i++) {
+        operation();
+      }
+      iterations += batch;
+      batch *= 2;
+      now = steady_clock::now();
+    }
+    syscalls = counter_.Read() - syscalls;
+    allocs = allocations.load() - allocs;
+
+    Result_t result;
+    result.name = name;
+    result.tree = tree;
+    result.iterations = iterations;
+    result.ns =
+        std::chrono::duration<double, std::nano>(now - start).count() /
+        iterations;
+    result.allocs = double(allocs) / iterations;
+    result.syscalls = double(syscalls) / iterations;
+    Print(result);
+  }
+
+private:
+  void Print(const Result_t &result) {
+    if (options_.csv) {
+      if (!headerPrinted_) {
+        printf("tree,name,iterations,ns_per_op,allocs_per_op,"
+               "syscalls_per_op,syscall_counter\n");
+        headerPrinted_ = true;
+      }
+      printf("%s,%s,%llu,%.1f,%.2f,%.2f,%s\n", result.tree.c_str(),
+             result.name.c_str(), (unsigned long long)result.iterations,
+             result.ns, result.allocs, result.syscalls, counter_.Source());
+    } else {
+      printf("{\"tree\":\"%s\",\"name\":\"%s\",\"iterations\":%llu,"
+             "\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,"
+             "\"syscalls_per_op\":%.2f,\"syscall_counter\":\"%s\"}\n",
+             result.tree.c_str(), result.name.c_str(),
+             (unsigned long long)result.iterations, result.ns, result.allocs,
+             result.syscalls, counter_.Source());
+    }
+    fflush(stdout);
+  }
+
+  const Options_t &options_;
+  SyscallCounter counter_;
+  bool headerPrinted_{false};
+};
+
+/**
+ * @brief Runs every case against the tree LinuxParser currently points at
+ */
+void runSuite(Bench &bench, const std::string &tree, unsigned workers) {
+  using namespace LinuxParser;
+  std::vector<int> pids = Pids();
+  if (pids.empty()) {
+    fprintf(stderr, "%s: no pid found\n", tree.c_str());
+    return;
+  }
+  /* Per-pid cases walk over every pid so the cost is a host average */
+  std::size_t next = 0;
+  auto nextPid = [&] {
+    int pid = pids[next];
+    next = (next + 1) % pids.size();
+    return pid;
+  };
+  MemoryUtilData_t memory;
+  StatSnapshot_t snapshot;
+  ProcessTable::Stat_t stat;
+  using StarttimeParser = StatParser<Field::kStarttime>;
+  using FullParser =
+      StatParser<Field::kComm, Field::kState, Field::kMinflt, Field::kUtime,
+                 Field::kStime, Field::kStarttime, Field::kRss,
+                 Field::kProcessor>;
+  StarttimeParser::Record_t starttime;
+  FullParser::Record_t full;
+
+  bench.Run(tree, "LinuxParser::OperatingSystem", [] { OperatingSystem(); });
+  bench.Run(tree, "LinuxParser::Kernel", [] { Kernel(); });
+  bench.Run(tree, "LinuxParser::Pids", [] { Pids(); });
+  std::vector<int> scan;
+  PidDelta_t delta;
+  bench.Run(tree, "LinuxParser::Pids(reused)", [&] { Pids(scan); });
+  bench.Run(tree, "LinuxParser::Pids(delta)", [&] { Pids(scan, &delta); });
+  bench.Run(tree, "LinuxParser::MemoryUtilization",
+            [&] { MemoryUtilization(memory); });
+  bench.Run(tree, "LinuxParser::UpTime", [] { UpTime(); });
+  bench.Run(tree, "LinuxParser::ReadStatSnapshot",
+            [&] { ReadStatSnapshot(snapshot); });
+  bench.Run(tree, "LinuxParser::TotalProcesses", [] { TotalProcesses(); });
+  bench.Run(tree, "LinuxParser::RunningProcesses",
+            [] { RunningProcesses(); });
+  bench.Run(tree, "LinuxParser::Jiffies", [] { Jiffies(); });
+  bench.Run(tree, "StatParser(table)",
+            [&] { ProcessTable::StatParser::Read(nextPid(), stat); });
+  bench.Run(tree, "StatParser(starttime)",
+            [&] { StarttimeParser::Read(nextPid(), starttime); });
+  bench.Run(tree, "StatParser(to processor)",
+            [&] { FullParser::Read(nextPid(), full); });
+  bench.Run(tree, "LinuxParser::Command",
+            [&] { Command(std::to_string(nextPid())); });
+  bench.Run(tree, "LinuxParser::Ram", [&] { Ram(nextPid()); });
+  Statm_t statm;
+  bench.Run(tree, "LinuxParser::ReadStatm",
+            [&] { ReadStatm(nextPid(), statm); });
+  SmapsRollup_t rollup;
+  bench.Run(tree, "LinuxParser::ReadSmapsRollup",
+            [&] { ReadSmapsRollup(nextPid(), rollup); });
+  ProcIo_t io;
+  bench.Run(tree, "LinuxParser::ReadProcIo",
+            [&] { ReadProcIo(nextPid(), io); });
+  bench.Run(tree, "LinuxParser::Uid",
+            [&] { Uid(std::to_string(nextPid())); });
+  bench.Run(tree, "LinuxParser::User", [&] { User("0"); });
+
+  System scanAll(workers, false, false);
+  bench.Run(tree, "System::Processes(full)", [&] {
+    scanAll.Refresh();
+    scanAll.Processes();
+    scanAll.TopProcesses(10);
+  });
+  System system(workers);
+  bench.Run(tree, "System::Processes", [&] {
+    system.Refresh();
+    system.Processes();
+    system.TopProcesses(10);
+  });
+  System withIo(workers);
+  withIo.SampleIo();
+  bench.Run(tree, "System::Processes(io)", [&] {
+    withIo.Refresh();
+    withIo.Processes();
+    withIo.TopProcesses(10);
+  });
+  Collector collector(system, 10, std::chrono::seconds(1));
+  bench.Run(tree, "Collector::Sample", [&] { collector.Sample(); });
+}
+
+/**
+ * @brief Records a tick and replays it, the rows must come back as
+ * written (commands with their arguments separated by spaces)
+ *
+ * @return {bool} : false if the replayed tick differs
+ */
+bool checkRecording() {
+  char path[] = "/tmp/monitor_recording.XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return false;
+  }
+  close(fd);
+
+  Snapshot_t snapshot;
+  snapshot.tick = 1;
+  snapshot.sampledAtNs = 1000000000;
+  snapshot.operatingSystem = "Fixture Linux";
+  snapshot.kernel = "6.0.0";
+  ProcessRow_t row;
+  row.pid = 42;
+  row.user = "root";
+  row.ramKb = 2048;
+  row.uptime = 7;
+  row.command = std::string("/bin/sleep\0--foo\0bar\0", 21);
+  snapshot.processes.push_back(row);
+
+  Recorder recorder;
+  bool appended = recorder.Open(path) && recorder.Append(snapshot);
+  recorder.Close();
+  Player player;
+  std::shared_ptr<const Snapshot_t> replayed;
+  if (appended && player.Open(path) && player.TickCount() == 1) {
+    replayed = player.Load(0);
+  }
+  unlink(path);
+
+  if (replayed == nullptr || replayed->processes.size() != 1) {
+    fprintf(stderr, "recording: tick not replayed\n");
+    return false;
+  }
+  const ProcessRow_t &back = replayed->processes.front();
+  const char *expected = "/bin/sleep --foo bar ";
+  if (back.pid != row.pid || back.user != row.user ||
+      back.ramKb != row.ramKb || back.uptime != row.uptime ||
+      back.command != expected) {
+    fprintf(stderr, "recording: replayed command \"%s\", expected \"%s\"\n",
+            back.command.c_str(), expected);
+    return false;
+  }
+  return true;
+}
+
+bool parseOptions(int argc, char *argv[], Options_t &options) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--csv") == 0) {
+      options.csv = true;
+    } else if (strcmp(arg, "--check-recording") == 0) {
+      options.checkRecording = true;
+    } else if (value == nullptr) {
+      return false;
+    } else if (strcmp(arg, "--fixture-processes") == 0) {
+      options.fixtureProcesses = strtoul(value, nullptr, 10);
+      i++;
+    } else if (strcmp(arg, "--fixture-root") == 0) {
+      options.fixtureRoot = value;
+      i++;
+    } else if (strcmp(arg, "--workers") == 0) {
+      options.workers = std::max(1l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(arg, "--min-time-ms") == 0) {
+      options.minTimeMs = std::max(1l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(arg, "--filter") == 0) {
+      options.filter = value;
+      i++;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options_t options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr,
+            "usage: %s [--csv] [--filter NAME] [--min-time-ms MS]\n"
+            "          [--workers N] [--fixture-processes N] "
+            "[--fixture-root DIR]\n"
+            "       %s --check-recording\n",
+            argv[0], argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (options.checkRecording) {
+    return checkRecording() ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  Bench bench(options);
+  runSuite(bench, "live", options.workers);
+
+  /* The fixture is only generated when no existing tree is given */
+  std::string root = options.fixtureRoot;
+  bool generated = false;
+  if (root.empty() || access((root + "/proc/stat").c_str(), R_OK) != 0) {
+    if (root.empty()) {
+      char pattern[] = "/tmp/monitor_bench.XXXXXX";
+      if (mkdtemp(pattern) == nullptr) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+      }
+      root = pattern;
+    }
+    Fixture::Options_t fixture;
+    fixture.processes = options.fixtureProcesses;
+    if (!Fixture::Generate(root, fixture)) {
+      perror(root.c_str());
+      return EXIT_FAILURE;
+    }
+    generated = options.fixtureRoot.empty();
+  }
+  Fixture::Use(root);
+  runSuite(bench, "fixture", options.workers);
+
+  if (generated) {
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    if (error) {
+      fprintf(stderr, "could not remove %s: %s\n", root.c_str(),
+              error.message().c_str());
+    }
+  }
+  return EXIT_SUCCESS;
+}
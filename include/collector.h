@@ -0,0 +1,100 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "snapshot.h"
+#include "system.h"
+
+/*
+Samples the system on its own thread at a fixed cadence and publishes
+each tick as an immutable Snapshot_t. Ticks are scheduled on the
+monotonic clock from the start time, so a slow /proc read or a slow
+render does not shift the following ticks.
+*/
+class Collector {
+public:
+  /**
+   * @brief Construct a new Collector object
+   *
+   * @param system : System sampled, only touched by the collector thread
+   * once started
+   * @param n : Number of top processes kept in each snapshot
+   * @param period : Sampling period
+   */
+  Collector(System &system, std::size_t n, std::chrono::milliseconds period);
+  /**
+   * @brief Stops the sampling thread
+   */
+  ~Collector();
+
+  /**
+   * @brief Starts the sampling thread, the first tick is taken immediately
+   */
+  void Start();
+  /**
+   * @brief Stops the sampling thread and waits for it to exit
+   */
+  void Stop();
+  /**
+   * @brief Returns the most recent snapshot
+   *
+   * @return {std::shared_ptr<const Snapshot_t>} : Latest snapshot, null
+   * until the first tick is published
+   */
+  std::shared_ptr<const Snapshot_t> Latest() const;
+  /**
+   * @brief Refreshes the system and copies what is displayed into a new
+   * snapshot. Called by the sampling thread, can also be called directly
+   * when no thread is running.
+   *
+   * @return {std::shared_ptr<Snapshot_t>} : The new snapshot
+   */
+  std::shared_ptr<Snapshot_t> Sample();
+  /**
+   * @brief Sets a function called on the sampling thread with every new
+   * snapshot, right after it is published. Must be set before Start.
+   *
+   * @param sink : Consumer of the snapshots
+   */
+  void OnSample(std::function<void(const Snapshot_t &)> sink);
+  /**
+   * @brief Returns the profiler of the sampled system, the display adds
+   * its render time to it
+   *
+   * @return {TickProfiler&} : Profiler of the system, thread safe
+   */
+  TickProfiler &Profiler();
+
+private:
+  /**
+   * @brief Body of the sampling thread
+   */
+  void Run();
+
+  System &system_;
+  std::size_t n_;
+  std::chrono::milliseconds period_;
+  std::uint64_t tick_{0};
+  std::chrono::steady_clock::time_point scheduled_;
+  std::string operatingSystem_;
+  std::string kernel_;
+  std::function<void(const Snapshot_t &)> sink_;
+
+  // Accessed with std::atomic_load / std::atomic_store
+  std::shared_ptr<const Snapshot_t> latest_;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  bool running_{false};
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "snapshot.h"
+
+enum class ExportFormat { kNdjson, kCsv };
+
+/*
+Serializes snapshots for log pipelines, one record per tick.
+NDJSON writes one JSON object per line holding the system counters and
+the process rows. CSV writes one line per process row with the system
+counters repeated, after a header line. With the profile enabled, the
+stage timings of the tick are added as a "profile" object (NDJSON) or as
+trailing columns (CSV).
+Records are formatted into a buffer kept across ticks with to_chars, so
+steady state ticks do not allocate.
+*/
+class Exporter {
+public:
+  /**
+   * @brief Construct a new Exporter object
+   *
+   * @param format : Output format
+   * @param out : Stream written to, not closed by the exporter
+   * @param profile : Also write the tick profile (stage timings and
+   * syscalls)
+   */
+  Exporter(ExportFormat format, FILE *out, bool profile = false);
+  /**
+   * @brief Writes the record of one tick and flushes the stream
+   *
+   * @param snapshot : Tick to write
+   * @return {bool} : false if the stream could not be written
+   */
+  bool Write(const Snapshot_t &snapshot);
+  /**
+   * @brief Parses a format name
+   *
+   * @param name : "ndjson" or "csv"
+   * @param format : Parsed format
+   * @return {bool} : false if the name is unknown
+   */
+  static bool ParseFormat(std::string_view name, ExportFormat &format);
+
+private:
+  void FormatNdjson(const Snapshot_t &snapshot);
+  void FormatCsv(const Snapshot_t &snapshot);
+  void AppendCsvSystem(const Snapshot_t &snapshot);
+  void AppendNdjsonProfile(const TickProfile_t &profile);
+  void AppendCsvProfile(const TickProfile_t &profile);
+  void Append(std::string_view text);
+  void AppendInteger(long long value);
+  /**
+   * @brief Appends a number with 4 decimals, null (NDJSON) or an empty
+   * cell (CSV) when it is not finite
+   */
+  void AppendFloat(float value);
+  /**
+   * @brief Appends a memory size of ProcessRow_t
+   *
+   * @param size : Size, negative when unknown (kernel thread, zombie)
+   * @param missing : Text written when the size is unknown
+   */
+  void AppendSize(long size, std::string_view missing);
+  void AppendJsonString(std::string_view text);
+  void AppendCsvString(std::string_view text);
+
+  ExportFormat format_;
+  FILE *out_;
+  bool profile_;
+  std::string buffer_;
+  bool headerWritten_{false};
+};
+
+#endif
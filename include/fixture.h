@@ -0,0 +1,44 @@
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include <cstddef>
+#include <string>
+
+/*
+Synthetic /proc tree generator.
+Generate writes a root/proc directory with N processes whose stat, status,
+statm and cmdline files follow the kernel formats, plus root/etc/passwd
+and root/etc/os-release. A share of the processes get nasty comm values
+(spaces, parentheses, fake fields) to exercise the parsers. Point the
+monitor at the tree with Use, or with --proc-root, --passwd and
+--os-release on the command line.
+*/
+namespace Fixture {
+
+struct Options_t {
+  std::size_t processes = 1000;
+  int cores = 8;
+  int users = 50;
+  unsigned seed = 1;
+};
+
+/**
+ * @brief Writes a synthetic tree under root, root is created if needed
+ * and existing files are overwritten
+ *
+ * @param root : Directory receiving proc/ and etc/
+ * @param options : Size of the tree
+ * @return {bool} : false if a file could not be written
+ */
+bool Generate(const std::string &root, const Options_t &options);
+
+/**
+ * @brief Points LinuxParser at a tree written by Generate
+ *
+ * @param root : Directory given to Generate
+ */
+void Use(const std::string &root);
+
+} // namespace Fixture
+
+#endif
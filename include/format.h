@@ -1,9 +1,13 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace Format {
+// Size of the buffer taken by ElapsedTime, fits any long of hours
+constexpr std::size_t kElapsedTimeSize{32};
 /**
  * @brief Extracts hours minutes and seconds from the input
  * and returns a formatted string in the format HH:MM:SS
@@ -12,6 +16,15 @@ namespace Format {
  * @return {string} : The formatted time string
  */
 std::string ElapsedTime(long times);
+/**
+ * @brief Formats a duration as HH:MM:SS into a caller buffer, without
+ * allocating
+ *
+ * @param seconds : The time in seconds
+ * @param buffer : Storage of the text
+ * @return {string_view} : The formatted time, points into buffer
+ */
+std::string_view ElapsedTime(long seconds, char (&buffer)[kElapsedTimeSize]);
 }; // namespace Format
 
-#endif
\ No newline at end of file
+#endif
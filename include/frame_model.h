@@ -0,0 +1,100 @@
+#ifndef FRAME_MODEL_H
+#define FRAME_MODEL_H
+
+#include <cstddef>
+#include <curses.h>
+#include <string_view>
+#include <vector>
+
+/*
+Character and color of every cell of a window, as last drawn.
+A frame is composed in full into the model with Put* then Flush compares
+it with the frame already on screen and only issues curses calls for the
+changed span of each changed row. Numbers are formatted with to_chars
+into fixed buffers, composing a frame does not allocate.
+*/
+class FrameModel {
+public:
+  FrameModel() = default;
+  /**
+   * @brief Construct a new FrameModel object
+   *
+   * @param window : Window drawn, nothing is drawn if null
+   * @param margin : Cells left untouched on each side (1 for a box)
+   */
+  FrameModel(WINDOW *window, int margin);
+
+  /**
+   * @brief Returns the width of the window
+   *
+   * @return {int} : Number of columns, borders included
+   */
+  int Width() const { return width_; }
+  /**
+   * @brief Blanks the frame being composed
+   */
+  void Clear();
+  /**
+   * @brief Writes text into the frame being composed, clipped to the
+   * window and to width cells
+   *
+   * @param y : Row in window coordinates
+   * @param x : Column in window coordinates
+   * @param text : Text, control characters are shown as spaces and
+   * each non-ASCII character (UTF-8 sequence) as one '?'
+   * @param pair : Color pair, 0 for the default colors
+   * @param width : Maximum number of cells, -1 for no limit
+   */
+  void Put(int y, int x, std::string_view text, short pair = 0,
+           int width = -1);
+  /**
+   * @brief Writes an integer right aligned in width cells
+   *
+   * @param y : Row in window coordinates
+   * @param x : Column in window coordinates
+   * @param value : Number written
+   * @param width : Cells of the field, 0 to left align without padding
+   * @param pair : Color pair, 0 for the default colors
+   */
+  void PutInteger(int y, int x, long long value, int width = 0,
+                  short pair = 0);
+  /**
+   * @brief Writes a number with a fixed number of decimals right aligned
+   * in width cells
+   *
+   * @param y : Row in window coordinates
+   * @param x : Column in window coordinates
+   * @param value : Number written
+   * @param precision : Number of decimals
+   * @param width : Cells of the field, 0 to left align without padding
+   * @param pair : Color pair, 0 for the default colors
+   */
+  void PutFixed(int y, int x, double value, int precision, int width = 0,
+                short pair = 0);
+  /**
+   * @brief Draws the cells that changed since the previous Flush and
+   * marks the window for the next doupdate()
+   *
+   * @return {bool} : false if nothing changed
+   */
+  bool Flush();
+
+private:
+  struct Cell_t {
+    char ch = ' ';
+    short pair = 0;
+    bool operator!=(const Cell_t &other) const {
+      return ch != other.ch || pair != other.pair;
+    }
+  };
+
+  WINDOW *window_{nullptr};
+  int margin_{0};
+  int height_{0};
+  int width_{0};
+  std::vector<Cell_t> next_;
+  std::vector<Cell_t> drawn_;
+  std::vector<char> run_;
+};
+
+#endif
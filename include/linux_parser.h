@@ -1,24 +1,14 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <cstddef>
 #include <fstream>
 #include <regex>
 #include <string>
+#include <vector>
 
 namespace LinuxParser {
 
-// Defines
-#define KEY_UTIME ("utime")
-#define KEY_STIME ("stime")
-#define KEY_CUTIME ("cutime")
-#define KEY_CSTIME ("cstime")
-#define KEY_STARTTIME ("starttime")
-#define UTIME_IDX (13)
-#define STIME_IDX (14)
-#define CUTIME_IDX (15)
-#define CSTIME_IDX (16)
-#define STARTTIME_IDX (21)
-
 struct MemoryUtilData_t {
   float MEM_TOTAL = 0;
   float MEM_FREE = 0;
@@ -27,16 +17,56 @@ struct MemoryUtilData_t {
 };
 
 // Paths
-const std::string kProcDirectory{"/proc/"};
 const std::string kCmdlineFilename{"/cmdline"};
 const std::string kCpuinfoFilename{"/cpuinfo"};
 const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
+const std::string kStatmFilename{"/statm"};
+const std::string kSmapsRollupFilename{"/smaps_rollup"};
+const std::string kIoFilename{"/io"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
 const std::string kVersionFilename{"/version"};
-const std::string kOSPath{"/etc/os-release"};
-const std::string kPasswordPath{"/etc/passwd"};
+
+// Configurable roots, /proc/, /etc/os-release and /etc/passwd by default.
+// They are meant to be set once at startup, before any sampling thread
+// starts, e.g. to point the monitor at a synthetic tree (see Fixture).
+/**
+ * @brief Returns the directory holding the proc files, ends with '/'
+ *
+ * @return {const std::string&} : The proc directory
+ */
+const std::string &ProcDirectory();
+/**
+ * @brief Returns the path of the os-release file
+ *
+ * @return {const std::string&} : The os-release path
+ */
+const std::string &OSPath();
+/**
+ * @brief Returns the path of the passwd file
+ *
+ * @return {const std::string&} : The passwd path
+ */
+const std::string &PasswordPath();
+/**
+ * @brief Changes the directory holding the proc files
+ *
+ * @param directory : New directory, a trailing '/' is added if missing
+ */
+void SetProcDirectory(const std::string &directory);
+/**
+ * @brief Changes the path of the os-release file
+ *
+ * @param path : New path
+ */
+void SetOSPath(const std::string &path);
+/**
+ * @brief Changes the path of the passwd file
+ *
+ * @param path : New path
+ */
+void SetPasswordPath(const std::string &path);
 
 // System
 /**
@@ -67,7 +97,34 @@ float MemoryUtilization(MemoryUtilData_t &memoryUtilData);
  * @return {long int} : The system uptime in seconds.
  */
 long int UpTime();
+/**
+ * @brief Pids that appeared and disappeared between two scans
+ */
+struct PidDelta_t {
+  std::vector<int> added;
+  std::vector<int> removed;
+};
+// Bytes of directory entries fetched per getdents64 call
+constexpr std::size_t kDirentBufferSize{64 * 1024};
+/**
+ * @brief Lists the pids of the proc directory
+ *
+ * @return {std::vector<int>} : Pids in ascending order
+ */
 std::vector<int> Pids();
+/**
+ * @brief Lists the pids of the proc directory into a caller vector
+ * Entries are read in batches with getdents64 into a buffer kept by the
+ * calling thread and the names are parsed in place, nothing is
+ * allocated once the vectors reached their size.
+ *
+ * @param pids : Receives the pids in ascending order, its capacity is
+ * kept. With a delta it must hold the previous scan on input.
+ * @param delta : If not null, receives the pids added and removed since
+ * the previous scan held by pids
+ * @return {bool} : false if the directory could not be read entirely
+ */
+bool Pids(std::vector<int> &pids, PidDelta_t *delta = nullptr);
 /**
  * @brief Reads /proc/stat file and extracts the total number of processes
  * which is the value to the key "processes".
@@ -115,12 +172,61 @@ enum CPUStates {
 };
 
 /**
- * @brief Reads /proc/stat file and extracts the CPU utilization
+ * @brief Jiffies of one "cpu" line of /proc/stat, indexed by CPUStates
+ */
+struct CpuTimes_t {
+  long values[kGuestNice_ + 1] = {};
+
+  /**
+   * @brief Jiffies spent doing work (user, nice, system, irq, softirq, steal)
+   * guest and guest_nice are not added since they are already accounted
+   * for in user and nice.
+   *
+   * @return {long} : The number of active jiffies
+   */
+  long Active() const {
+    return values[kUser_] + values[kNice_] + values[kSystem_] +
+           values[kIRQ_] + values[kSoftIRQ_] + values[kSteal_];
+  }
+  /**
+   * @brief Jiffies spent idle (idle + iowait)
+   *
+   * @return {long} : The number of idle jiffies
+   */
+  long Idle() const { return values[kIdle_] + values[kIOwait_]; }
+  /**
+   * @brief Sum of active and idle jiffies
+   *
+   * @return {long} : The total number of jiffies
+   */
+  long Total() const { return Active() + Idle(); }
+};
+
+/**
+ * @brief All the counters of /proc/stat used by the monitor, filled by a
+ * single read of the file per tick
+ */
+struct StatSnapshot_t {
+  CpuTimes_t cpu;                 // aggregate "cpu" line
+  // Indexed by the N of the "cpuN" lines, zero for an offline CPU
+  std::vector<CpuTimes_t> cores;
+  long long ctxt = 0;             // context switches since boot
+  long long intr = 0;             // interrupts serviced since boot
+  int processes = 0;              // forks since boot
+  int procsRunning = 0;           // processes in runnable state
+  int procsBlocked = 0;           // processes blocked on I/O
+};
+
+/**
+ * @brief Reads /proc/stat once and fills every field of the snapshot.
+ * The cores vector is resized in place so its capacity is reused
+ * from one tick to the next.
  *
- * @return {std::vector<std::string>} : Vector containing the CPU utilization
- * data
+ * @param snapshot : Snapshot to fill
+ * @return {bool} : true if the file could be read
  */
-std::vector<std::string> CpuUtilization();
+bool ReadStatSnapshot(StatSnapshot_t &snapshot);
+
 /**
  * @brief Returns the CPU total utilization
  *
@@ -143,15 +249,90 @@ long IdleJiffies();
 // Processes
 std::string Command(std::string pid);
 /**
- * @brief Retrieves memory size of a process from /proc/pid/status file
- * We take the size indicated by the key "VmRSS:" and convert it to Mb
- * instead of VmSize which is the total virtual memory size of the process
- * because it includes shared memory and memory that is swapped out
+ * @brief Memory sizes of a process from /proc/pid/statm, in kB
+ * A process without an address space (kernel thread, zombie) has a
+ * size of 0.
+ */
+struct Statm_t {
+  long size = 0;     // total program size (VmSize)
+  long resident = 0; // resident set size (VmRSS)
+  long shared = 0;   // resident file-backed and shared pages
+  long text = 0;     // code
+  long data = 0;     // data + stack
+};
+/**
+ * @brief Reads /proc/pid/statm, a single line of seven page counts,
+ * with one read() into a stack buffer and without any heap allocation
+ *
+ * @param pid : Process ID
+ * @param statm : Structure to fill, in kB
+ * @return {bool} : false if the process is gone or the file is truncated
+ */
+bool ReadStatm(int pid, Statm_t &statm);
+/**
+ * @brief Retrieves the resident memory of a process from /proc/pid/statm
+ * The resident set size is used instead of VmSize, the total virtual
+ * memory size of the process, because it includes shared memory and
+ * memory that is swapped out
+ *
+ * @param pid : Process ID
+ * @return {long} : Resident memory in kB, -1 if the process has no
+ * address space or is gone
+ */
+long Ram(int pid);
+/**
+ * @brief Memory of a process summed over its mappings by
+ * /proc/pid/smaps_rollup, in kB
+ */
+struct SmapsRollup_t {
+  long rss = 0;
+  long pss = 0;          // resident pages divided by their number of users
+  long privateClean = 0;
+  long privateDirty = 0;
+  long swapPss = 0;
+
+  /**
+   * @brief Unique set size, the memory freed if the process exited
+   *
+   * @return {long} : Private clean + private dirty, in kB
+   */
+  long Uss() const { return privateClean + privateDirty; }
+};
+/**
+ * @brief Reads /proc/pid/smaps_rollup with one read() into a stack
+ * buffer. The kernel walks every mapping of the process to produce it,
+ * so it costs far more than statm (see MemorySampler).
+ *
+ * @param pid : Process ID
+ * @param rollup : Structure to fill
+ * @return {bool} : false if the process is gone, has no address space or
+ * the file cannot be read (other users' processes need ptrace access)
+ */
+bool ReadSmapsRollup(int pid, SmapsRollup_t &rollup);
+/**
+ * @brief I/O counters of a process from /proc/pid/io, since it started
+ */
+struct ProcIo_t {
+  unsigned long long rchar = 0;      // bytes read through read() & co
+  unsigned long long wchar = 0;      // bytes written through write() & co
+  unsigned long long syscr = 0;      // read syscalls
+  unsigned long long syscw = 0;      // write syscalls
+  unsigned long long readBytes = 0;  // bytes fetched from storage
+  unsigned long long writeBytes = 0; // bytes sent to storage
+  // Bytes written then truncated or deleted before reaching storage
+  unsigned long long cancelledWriteBytes = 0;
+};
+/**
+ * @brief Reads /proc/pid/io with one read() into a stack buffer and
+ * without any heap allocation
  *
  * @param pid : Process ID
- * @return {string} : Memory size of the process in Mb
+ * @param io : Structure to fill
+ * @return {bool} : false if the file cannot be read, errno is EACCES
+ * when the monitor may not trace the process (another user's process
+ * when not root)
  */
-std::string Ram(std::string pid);
+bool ReadProcIo(int pid, ProcIo_t &io);
 /**
  * @brief Reads /proc/pid/status file and extracts the UID associated with the
  * process the uid is the values associated with the key "Uid:"
@@ -160,38 +341,29 @@ std::string Ram(std::string pid);
  */
 std::string Uid(std::string pid);
 /**
- * @brief Reads /etc/passwd file and extracts the user name associated with the
- * UID the function loops through the file line by line formatting the line by
- * replacing
- * ':' with ' ' and then extracts the user name associated with the UID
- * if the UID is not found the function returns "UNKNOWN"
+ * @brief Returns the user name associated with the UID
+ * The name is served by the process-wide UserCache which loads /etc/passwd
+ * once and falls back to NSS for uids missing from the file.
+ * if the UID is not a number the function returns "UNKNOWN"
  * @param uid : User ID
  * @return {string} : User name associated with the UID
  */
 std::string User(std::string uid);
 /**
- * @brief Reads /proc/pid/stat file and extract necesary data
- * for process cpu utilization in a map :
- * idx 14 utime - CPU time spent in user code, measured in clock ticks
- * idx 15 stime - CPU time spent in kernel code, measured in clock ticks
- * idx 16 cutime - Waited-for children's CPU time spent in user code (in clock
- * ticks) idx 17 cstime - Waited-for children's CPU time spent in kernel code
- * (in clock ticks) idx 22 starttime - Time when the process started, measured
- * in clock ticks
+ * @brief Reads a file of a process directory with a single read() into
+ * a caller buffer, for the small records parsed without allocation
+ * (see StatParser)
  *
  * @param pid : Process ID
- * @return {std::map<std::string, long>} : Map containing the data
- */
-std::map<std::string, long> processUtilData(std::string pid);
-/**
- * @brief Reads the /proc/pid/stat file and extracts all the data
- * then returns the starttime at index 22 which is the uptime in seconds
- * of this process.
- *
- * @param pid : Process ID.
- * @return {long} : The uptime time of the process in seconds.
+ * @param filename : File name in the process directory, e.g. kStatFilename
+ * @param buffer : Receives the content
+ * @param capacity : Size of buffer
+ * @param size : Receives the number of bytes read
+ * @return {bool} : false if the process is gone or the file is empty,
+ * errno then tells why
  */
-long int UpTime(std::string pid);
+bool ReadPidFile(int pid, const std::string &filename, char *buffer,
+                 std::size_t capacity, std::size_t &size);
 
 }; // namespace LinuxParser
 
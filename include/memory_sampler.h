@@ -0,0 +1,52 @@
+#ifndef MEMORY_SAMPLER_H
+#define MEMORY_SAMPLER_H
+
+#include <chrono>
+#include <cstddef>
+
+#include "process_table.h"
+
+/*
+Budgeted PSS/USS sampler over /proc/pid/smaps_rollup.
+The kernel walks every mapping of a process to build smaps_rollup, which
+is far too expensive to do for every pid every tick. Each tick the top-K
+processes by RSS are refreshed first, then a round-robin walk goes on
+through the rest of the table from the pid where the previous tick
+stopped, until the CPU time spent by the sampling thread reaches the
+budget. Every value keeps the time it was read so its age can be shown.
+*/
+class MemorySampler {
+public:
+  /**
+   * @brief Construct a new MemorySampler object
+   *
+   * @param budget : CPU time the sampling thread may spend per tick
+   * @param top : Number of processes with the highest RSS refreshed
+   * every tick
+   */
+  MemorySampler(std::chrono::microseconds budget, std::size_t top);
+
+  /**
+   * @brief Refreshes the PSS and USS of as many processes as the budget
+   * allows, the top-K by RSS first. Processes without an address space
+   * are skipped, as are those whose smaps_rollup could not be read
+   * (no ptrace access) until their pid is reused.
+   *
+   * @param table : Process table just refreshed
+   */
+  void Sample(ProcessTable &table);
+
+private:
+  /**
+   * @brief Reads smaps_rollup for one row of the table
+   */
+  void Refresh(ProcessTable &table, std::size_t row,
+               std::chrono::steady_clock::time_point now);
+
+  std::chrono::nanoseconds budget_;
+  std::size_t top_;
+  // Round-robin position, the walk resumes at the first pid >= nextPid_
+  int nextPid_{0};
+};
+
+#endif
@@ -1,16 +1,30 @@
 #ifndef NCURSES_DISPLAY_H
 #define NCURSES_DISPLAY_H
 
+#include <cstdint>
+#include <functional>
+#include <string>
 #include <curses.h>
 
-#include "process.h"
+#include "collector.h"
+#include "frame_model.h"
+#include "player.h"
+#include "snapshot.h"
 #include "system.h"
 
 namespace NCursesDisplay {
-void Display(System &system, int n = 10);
-void DisplaySystem(System &system, WINDOW *window);
-void DisplayProcesses(std::vector<Process> &processes, WINDOW *window, int n);
-std::string ProgressBar(float percent);
+void Display(Collector &collector, int n = 10, bool stats = false,
+             std::function<std::string()> notice = {});
+void Replay(Player &player, std::int64_t startNs, int n = 10);
+void DisplaySystem(const Snapshot_t &snapshot, FrameModel &frame);
+void DisplayProcesses(const std::vector<ProcessRow_t> &processes,
+                      FrameModel &frame, int n, bool pss = false,
+                      bool io = false);
+void DisplayStats(const TickProfile_t &profile, FrameModel &frame);
+void ProgressBar(float percent, FrameModel &frame, int y, int x);
+void DisplayCoreGrid(const std::vector<CpuLoad_t> &cores, FrameModel &frame,
+                     int width, int row);
+int CoreGridRows(int nbCores, int width);
 }; // namespace NCursesDisplay
 
-#endif
\ No newline at end of file
+#endif
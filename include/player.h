@@ -0,0 +1,80 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "recording.h"
+#include "snapshot.h"
+
+/*
+Reads back a recording made with --record, see recording.h.
+The file is mapped read-only, ticks are only paged in when they are
+loaded, and seeking is a binary search over the on-disk index so it
+stays O(log n) on multi-GB recordings.
+*/
+class Player {
+public:
+  Player() = default;
+  /**
+   * @brief Unmaps the recording
+   */
+  ~Player();
+  Player(const Player &) = delete;
+  Player &operator=(const Player &) = delete;
+
+  /**
+   * @brief Maps a recording and checks its header
+   *
+   * @param path : Path of the recording
+   * @return {bool} : false if the file is missing or is not a recording
+   */
+  bool Open(const std::string &path);
+  /**
+   * @brief Returns the number of ticks in the recording
+   *
+   * @return {size_t} : Number of committed ticks
+   */
+  std::size_t TickCount() const;
+  /**
+   * @brief Returns the monotonic time of a tick
+   *
+   * @param tick : Tick number, lower than TickCount()
+   * @return {int64_t} : Time of the tick in nanoseconds
+   */
+  std::int64_t TimeNs(std::size_t tick) const;
+  /**
+   * @brief Returns the offset to add to a tick time to get the wall clock
+   * time (nanoseconds since the epoch)
+   *
+   * @return {int64_t} : Offset in nanoseconds
+   */
+  std::int64_t WallClockOffsetNs() const;
+  /**
+   * @brief Finds the last tick taken at or before a time
+   * Binary search over the index, O(log n).
+   *
+   * @param timeNs : Monotonic time in nanoseconds
+   * @return {size_t} : Tick number, 0 if the time is before the first tick
+   */
+  std::size_t Seek(std::int64_t timeNs) const;
+  /**
+   * @brief Rebuilds the snapshot of a tick
+   *
+   * @param tick : Tick number, lower than TickCount()
+   * @return {std::shared_ptr<const Snapshot_t>} : The recorded snapshot
+   */
+  std::shared_ptr<const Snapshot_t> Load(std::size_t tick) const;
+
+private:
+  void Close();
+  const Recording::IndexEntry_t &Entry(std::size_t tick) const;
+
+  const char *map_{nullptr};
+  std::size_t size_{0};
+  Recording::Header_t header_{};
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef PROC_EVENTS_H
+#define PROC_EVENTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+Keeps the set of live pids from the kernel proc connector.
+A thread subscribed to the netlink connector adds a pid on fork and
+removes it on exit, so a tick lists the pids without reading /proc.
+When a process exits its final comm, CPU time and runtime are kept so
+processes that live less than one tick are reported too. The exit event
+is sent after the parent got SIGCHLD, so /proc/pid/stat is often gone
+already: the accounting record taskstats sends earlier in the exit
+(genetlink TASKSTATS) is used then. It only covers the leader thread so
+it is ignored for multithreaded groups, whose exit keeps the last
+counters of the table when the stat is gone.
+The set has to be rebuilt from a full /proc scan (Reset) after Start and
+whenever events were lost because the socket buffer overflowed. Forks
+and exits received while the scan runs are logged and applied on top of
+its result, the scan may have passed their pid already.
+Only thread group leaders are tracked, threads are ignored except for
+the last one of a group whose leader exited first.
+*/
+
+/**
+ * @brief A process that exited, as seen by the proc connector
+ */
+struct ExitRecord_t {
+  int pid = 0;
+  char comm[16]{};
+  // Exit status, or minus the signal number if it was killed
+  int exitCode = 0;
+  float cpuSeconds = 0;     // user + system time over its whole life
+  float runtimeSeconds = 0; // time from start to exit
+  // false if neither /proc/pid/stat nor taskstats had the final
+  // counters, see System::Processes
+  bool complete = false;
+};
+
+class ProcEvents {
+public:
+  // Exits kept between two TakeExits, older ones are dropped
+  static constexpr std::size_t kMaxExits{4096};
+
+  ProcEvents() = default;
+  /**
+   * @brief Stops the listening thread
+   */
+  ~ProcEvents();
+  ProcEvents(const ProcEvents &) = delete;
+  ProcEvents &operator=(const ProcEvents &) = delete;
+
+  /**
+   * @brief Subscribes to the proc connector and starts listening
+   * Needs CAP_NET_ADMIN and the initial pid namespace.
+   *
+   * @return {bool} : false if the connector is unavailable
+   */
+  bool Start();
+  /**
+   * @brief Returns whether events are received
+   *
+   * @return {bool} : true once Start succeeded
+   */
+  bool Active() const;
+  /**
+   * @brief Copies the live pids in ascending order
+   *
+   * @param pids : Filled with the pids, cleared first
+   * @return {bool} : false if the set is not trustworthy (never reset or
+   * events lost), a full scan and Reset are then needed; events are
+   * logged from this call until Reset
+   */
+  bool Pids(std::vector<int> &pids);
+  /**
+   * @brief Replaces the set with the result of a full /proc scan, then
+   * applies the events logged since Pids asked for it
+   *
+   * @param pids : Pids listed by the scan
+   */
+  void Reset(const std::vector<int> &pids);
+  /**
+   * @brief Removes a pid found dead by a reader
+   *
+   * @param pid : Pid whose /proc entry is gone
+   */
+  void Forget(int pid);
+  /**
+   * @brief Moves the exits seen since the previous call
+   *
+   * @param exits : Receives the exit records, cleared first
+   * @return {uint64_t} : Number of exits dropped because more than
+   * kMaxExits happened since the previous call
+   */
+  std::uint64_t TakeExits(std::vector<ExitRecord_t> &exits);
+
+private:
+  /**
+   * @brief Body of the listening thread
+   */
+  void Run();
+  /**
+   * @brief Applies one datagram of events
+   */
+  void Dispatch(const char *buffer, long size);
+  /**
+   * @brief Records the exit of a process
+   */
+  void Exited(int pid, std::uint32_t status);
+  /**
+   * @brief Registers for the taskstats exit records of every CPU
+   *
+   * @return {bool} : false if taskstats is unavailable
+   */
+  bool StartTaskstats();
+  /**
+   * @brief Reads the taskstats records queued on the socket
+   */
+  void DrainTaskstats();
+  /**
+   * @brief Keeps the accounting of one taskstats message until the exit
+   * event of its process
+   */
+  void Accounted(const char *buffer, long size);
+  /**
+   * @brief Adds or removes a pid of the set, logging the change while a
+   * scan runs. mutex_ must be held.
+   */
+  void Insert(int pid);
+  void Erase(int pid);
+
+  int socket_{-1};
+  int wakeup_{-1}; // eventfd signalled to stop the thread
+  int taskstats_{-1};
+  std::uint16_t family_{0}; // genetlink id of TASKSTATS
+  std::thread thread_;
+
+  std::mutex mutex_;
+  std::set<int> pids_;
+  bool synced_{false};
+  // Set between a Pids call that asked for a scan and its Reset
+  bool scanning_{false};
+  // Events were lost during the scan, Reset cannot sync the set
+  bool overflowed_{false};
+  // Changes seen during the scan, pid and whether it was added
+  std::vector<std::pair<int, bool>> scanLog_;
+  // Taskstats records waiting for their exit event, listener thread only
+  std::map<int, ExitRecord_t> accounting_;
+  // Leaders that exited while other threads of their group still run,
+  // listener thread only
+  std::set<int> leaderGone_;
+  std::vector<ExitRecord_t> exits_;
+  std::uint64_t dropped_{0};
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef PROC_FILES_H
+#define PROC_FILES_H
+
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/*
+Descriptors of the system-wide proc files read every tick.
+Each file is opened once and re-read from offset 0 with pread, which
+saves the open/close syscalls and the stream setup of every refresh.
+A descriptor is reopened when a read fails and all of them are reopened
+when LinuxParser::SetProcDirectory points to another tree.
+*/
+class ProcFiles {
+public:
+  enum File { kStat_, kMeminfo_, kUptime_, kFiles_ };
+
+  /**
+   * @brief Returns the registry shared by the whole process
+   *
+   * @return {ProcFiles&} : The process-wide instance
+   */
+  static ProcFiles &Instance();
+  /**
+   * @brief Reads the whole file into buffer
+   * The buffer is sized once and only grows until the file fits, its
+   * size is not the length of the content: callers reuse it from one
+   * tick to the next and parse text.
+   *
+   * @param file : File to read
+   * @param buffer : Storage for the content of the file
+   * @param text : Content of the file, points into buffer
+   * @return {bool} : false if the file cannot be opened or read
+   */
+  bool Read(File file, std::string &buffer, std::string_view &text);
+
+private:
+  ProcFiles() = default;
+  ~ProcFiles();
+  /**
+   * @brief Closes every descriptor
+   */
+  void CloseAll();
+  /**
+   * @brief Opens a file under directory_
+   *
+   * @return {bool} : false if it cannot be opened
+   */
+  bool Open(File file);
+
+  std::mutex mutex_;
+  int fds_[kFiles_]{-1, -1, -1};
+  // Proc directory the descriptors were opened under
+  std::string directory_;
+};
+
+#endif
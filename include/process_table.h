@@ -0,0 +1,406 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "stat_parser.h"
+#include "tick_profiler.h"
+
+/*
+Persistent process table stored as columns.
+Every attribute lives in its own contiguous array indexed by row, rows
+are kept sorted by pid. A refresh is a merge join of the previous table
+with the pids of the new scan (ascending too): survivors carry their
+state to the new row, new pids get a fresh row and dead ones are retired,
+all in one sequential pass over the columns.
+User and command are ids of the process-wide StringPool, read on first
+use then cached until the process calls exec or kRecheckSeconds passed.
+Rows may also be kept without reading their stat (see RefreshScheduler),
+their counters then stay those of the last read and the next read
+spreads its CPU delta over every tick since.
+I/O counters are only read when the caller passes them to Add; a
+process whose io file was denied (EACCES) is flagged so it is not tried
+again until its pid is reused.
+PSS and USS are only filled by a MemorySampler, with the time they were
+read since a value may be several ticks old.
+Sorting, filtering and top-K work on a compact (key, row) array, the
+columns themselves never move.
+*/
+class ProcessTable {
+public:
+  // kIo orders by storage bytes read + written per second
+  enum class Order { kCpu, kRss, kIo, kPid };
+  /**
+   * @brief I/O rates of a process over its last interval, per second
+   */
+  struct IoRates_t {
+    float readBytes = 0;
+    float writeBytes = 0;
+    float syscr = 0;
+    float syscw = 0;
+  };
+  // Fields of /proc/pid/stat the table is refreshed from, parsing stops
+  // at rss (field 24) instead of going through the whole record
+  using StatParser =
+      LinuxParser::StatParser<LinuxParser::Field::kComm,
+                              LinuxParser::Field::kState,
+                              LinuxParser::Field::kUtime,
+                              LinuxParser::Field::kStime,
+                              LinuxParser::Field::kNumThreads,
+                              LinuxParser::Field::kStarttime,
+                              LinuxParser::Field::kRss>;
+  using Stat_t = StatParser::Record_t;
+  // Returned by Find when the pid has no row
+  static constexpr std::size_t kNoRow = SIZE_MAX;
+
+  /**
+   * @brief Construct a new ProcessTable object
+   *
+   * @param profiler : Times the status and user reads, must outlive the
+   * table
+   */
+  explicit ProcessTable(TickProfiler &profiler);
+  /**
+   * @brief Releases the interned strings held by the rows
+   */
+  ~ProcessTable();
+  ProcessTable(const ProcessTable &) = delete;
+  ProcessTable &operator=(const ProcessTable &) = delete;
+
+  /**
+   * @brief Starts a refresh, followed by Add or Keep for every live pid
+   * and End
+   *
+   * @param elapsed : Seconds elapsed since the previous refresh
+   * @param uptime : System uptime in seconds, used for new processes
+   */
+  void Begin(float elapsed, long uptime);
+  /**
+   * @brief Adds the stat of a live process to the refresh
+   * If the starttime changed the pid was reused by a new process and the
+   * row starts over as a new one. The cached command and user are dropped
+   * when comm changes (exec) or every kRecheckSeconds.
+   * ------------------------------------------------------
+   * |               CPU Utilization                      |
+   * |----------------------------------------------------|
+   * | Formula:                                           |
+   * |   Time spent by the process in clock ticks :       |
+   * |   total_time = utime + stime                       |
+   * |   Over the last sampling interval :                |
+   * |   CPU Utilization = (delta(total_time) / clk freq) |
+   * |                      / elapsed seconds             |
+   * |   On the first sample the interval starts when the |
+   * |   process started :                                |
+   * |   seconds = uptime - (starttime / clk frequency)   |
+   * ------------------------------------------------------
+   *
+   * @param pid : Process ID, greater than the pid of the previous Add
+   * @param stat : /proc/pid/stat of the process
+   * @param io : /proc/pid/io of the process, null if it was not read
+   */
+  void Add(int pid, const Stat_t &stat,
+           const LinuxParser::ProcIo_t *io = nullptr);
+  /**
+   * @brief Carries a live process whose stat was not read this tick, its
+   * counters and CPU utilization are those of its last read
+   *
+   * @param pid : Process ID, greater than the pid of the previous Add
+   */
+  void Keep(int pid);
+  /**
+   * @brief Ends a refresh, pids neither added nor kept are retired
+   */
+  void End();
+
+  /**
+   * @brief Returns the number of rows
+   *
+   * @return {size_t} : Processes of the last refresh
+   */
+  std::size_t Size() const { return current_.pid.size(); }
+  /**
+   * @brief Returns the row of a pid, by binary search
+   *
+   * @param pid : Process ID
+   * @return {size_t} : Row of the pid, kNoRow if unknown
+   */
+  std::size_t Find(int pid) const;
+  /**
+   * @brief Returns the first row whose pid is not lower than pid
+   *
+   * @param pid : Process ID
+   * @return {size_t} : Row, Size() if every pid is lower
+   */
+  std::size_t LowerBound(int pid) const;
+
+  int Pid(std::size_t row) const { return current_.pid[row]; }
+  /**
+   * @brief CPU utilization over the last interval, as a fraction
+   */
+  float CpuUtilization(std::size_t row) const { return current_.cpu[row]; }
+  /**
+   * @brief User + system time over the whole life, in seconds
+   */
+  float CpuTime(std::size_t row) const;
+  /**
+   * @brief Resident set size in kB, from the rss field of stat
+   */
+  long Rss(std::size_t row) const;
+  /**
+   * @brief Start time of the process in clock ticks after boot
+   */
+  unsigned long long StartTime(std::size_t row) const {
+    return current_.startTime[row];
+  }
+  /**
+   * @brief Start time of the process in seconds after boot
+   */
+  long UpTime(std::size_t row) const;
+  char State(std::size_t row) const { return current_.state[row]; }
+  /**
+   * @brief Number of threads of the process at its last read
+   */
+  long Threads(std::size_t row) const { return current_.threads[row]; }
+  /**
+   * @brief Ticks since the process was last seen active: using CPU,
+   * runnable, in uninterruptible sleep or changing state. Only updated
+   * when the stat is read, kept rows count as idle.
+   */
+  unsigned IdleTicks(std::size_t row) const {
+    return current_.idleTicks[row];
+  }
+  /**
+   * @brief I/O rates over the interval of the last io read
+   */
+  const IoRates_t &IoRates(std::size_t row) const {
+    return current_.ioRate[row];
+  }
+  /**
+   * @brief Bytes written then truncated or deleted before reaching
+   * storage, since the process started
+   */
+  unsigned long long CancelledWriteBytes(std::size_t row) const {
+    return current_.io[row].cancelledWriteBytes;
+  }
+  /**
+   * @brief Whether the I/O columns of the row hold a read
+   */
+  bool IoKnown(std::size_t row) const {
+    return current_.ioState[row] == kIoKnown;
+  }
+  /**
+   * @brief Whether reading /proc/pid/io of the row failed with EACCES
+   */
+  bool IoDenied(std::size_t row) const {
+    return current_.ioState[row] == kIoDenied;
+  }
+  /**
+   * @brief Flags the row as not readable, its io file is skipped until
+   * the pid is reused
+   *
+   * @param row : Row of the process
+   */
+  void DenyIo(std::size_t row) { current_.ioState[row] = kIoDenied; }
+  /**
+   * @brief Proportional set size in kB, -1 until sampled
+   */
+  long Pss(std::size_t row) const { return current_.pss[row]; }
+  /**
+   * @brief Unique set size in kB, -1 until sampled
+   */
+  long Uss(std::size_t row) const { return current_.uss[row]; }
+  /**
+   * @brief Time of the last smaps_rollup read of the row, successful or
+   * not, the epoch if it was never read
+   */
+  std::chrono::steady_clock::time_point
+  MemorySampledAt(std::size_t row) const {
+    return current_.memoryAt[row];
+  }
+  /**
+   * @brief Stores the result of a smaps_rollup read
+   *
+   * @param row : Row of the process
+   * @param pss : Proportional set size in kB, -1 if the read failed
+   * @param uss : Unique set size in kB, -1 if the read failed
+   * @param at : Time of the read
+   */
+  void SetMemory(std::size_t row, long pss, long uss,
+                 std::chrono::steady_clock::time_point at);
+  const char *Comm(std::size_t row) const {
+    return current_.comm[row].data();
+  }
+  /**
+   * @brief Returns the user owning the process
+   * The uid is read from /proc/pid/status on first use and the name is
+   * kept in the StringPool.
+   *
+   * @param row : Row of the process
+   * @return {string} : User name
+   */
+  std::string User(std::size_t row);
+  /**
+   * @brief Returns the command line of the process
+   * Read from /proc/pid/cmdline on first use and kept in the StringPool.
+   *
+   * @param row : Row of the process
+   * @return {string} : Command line
+   */
+  std::string Command(std::size_t row);
+
+  /**
+   * @brief Returns the rows of the n first processes in the given order
+   * among those kept by the filter. Only a (key, row) array is ordered:
+   * nth_element isolates the first n then only those n keys are sorted.
+   * CPU and RSS are highest first, ties keep pid order.
+   *
+   * @param n : Number of rows wanted
+   * @param order : Sort order
+   * @param keep : Predicate on a row, false to filter the process out
+   * @return {const vector<size_t>&} : Rows, valid until the next call
+   */
+  template <typename Filter>
+  const std::vector<std::size_t> &Top(std::size_t n, Order order,
+                                      Filter keep);
+  /**
+   * @brief Returns the rows of the n first processes in the given order
+   *
+   * @param n : Number of rows wanted
+   * @param order : Sort order
+   * @return {const vector<size_t>&} : Rows, valid until the next call
+   */
+  const std::vector<std::size_t> &Top(std::size_t n,
+                                      Order order = Order::kCpu) {
+    return Top(n, order, [](std::size_t) { return true; });
+  }
+
+private:
+  using Comm_t = std::array<char, 16>;
+  enum IoState : unsigned char { kIoUnknown, kIoKnown, kIoDenied };
+  struct Columns_t {
+    std::vector<int> pid;
+    std::vector<unsigned long long> startTime; // clock ticks after boot
+    std::vector<long> ticks;                   // utime + stime
+    std::vector<float> cpu;                    // fraction of one CPU
+    std::vector<long> rss;                     // pages
+    std::vector<char> state;
+    std::vector<long> threads;
+    std::vector<Comm_t> comm;
+    std::vector<float> statAge;       // seconds since stat was read
+    std::vector<unsigned> idleTicks;  // ticks since last activity
+    std::vector<float> cacheAge; // seconds since user/command were read
+    std::vector<std::uint32_t> user;    // StringPool id
+    std::vector<std::uint32_t> command; // StringPool id
+    std::vector<LinuxParser::ProcIo_t> io; // counters of the last read
+    std::vector<IoRates_t> ioRate;
+    std::vector<IoState> ioState;
+    std::vector<float> ioAge; // seconds since io was read
+    std::vector<long> pss;              // kB, -1 until sampled
+    std::vector<long> uss;              // kB, -1 until sampled
+    std::vector<std::chrono::steady_clock::time_point> memoryAt;
+    void Clear();
+    void Reserve(std::size_t size);
+  };
+
+  // Period after which the cached command and user are read again
+  static constexpr float kRecheckSeconds{30.0f};
+
+  /**
+   * @brief Moves the row of pid from current_ to next_, retiring the rows
+   * of the pids skipped since the previous call
+   *
+   * @param pid : Process ID, greater than the pid of the previous call
+   * @param create : Create an empty row when pid is unknown
+   * @return {size_t} : Row in next_, kNoRow if pid is unknown and create
+   * is false
+   */
+  std::size_t Carry(int pid, bool create);
+  /**
+   * @brief Turns a read of /proc/pid/io into rates for a row of next_
+   * The first read of a process covers its whole life, like its CPU.
+   *
+   * @param row : Row in next_
+   * @param io : Counters just read
+   * @param seconds : Interval since the previous io read of the row
+   */
+  void UpdateIo(std::size_t row, const LinuxParser::ProcIo_t &io,
+                float seconds);
+  /**
+   * @brief Drops the interned strings of a row of current_
+   */
+  void Retire(std::size_t row);
+  /**
+   * @brief Drops the cached command and user of a row of next_
+   */
+  void InvalidateCache(std::size_t row);
+  /**
+   * @brief Appends the cpu (or rss) key of every kept row to keys_
+   */
+  template <typename Filter> void BuildKeys(Order order, Filter keep);
+
+  static long clkTck_;
+  static long pageKb_;
+
+  Columns_t current_;
+  Columns_t next_;
+  // Merge state of the refresh in progress
+  std::size_t cursor_{0};
+  float elapsed_{0};
+  long uptime_{0};
+
+  TickProfiler &profiler_;
+  std::vector<std::pair<float, std::uint32_t>> keys_;
+  std::vector<std::size_t> top_;
+};
+
+template <typename Filter>
+void ProcessTable::BuildKeys(Order order, Filter keep) {
+  keys_.clear();
+  keys_.reserve(Size());
+  for (std::size_t row = 0; row < Size(); row++) {
+    if (!keep(row)) {
+      continue;
+    }
+    const IoRates_t &io = current_.ioRate[row];
+    float key = order == Order::kCpu   ? current_.cpu[row]
+                : order == Order::kRss ? float(current_.rss[row])
+                : order == Order::kIo  ? io.readBytes + io.writeBytes
+                                       : 0.0f;
+    keys_.emplace_back(key, std::uint32_t(row));
+  }
+}
+
+template <typename Filter>
+const std::vector<std::size_t> &ProcessTable::Top(std::size_t n, Order order,
+                                                  Filter keep) {
+  BuildKeys(order, keep);
+
+  /* Highest key first, ties (and Order::kPid) keep the row order */
+  auto higher = [](const std::pair<float, std::uint32_t> &a,
+                   const std::pair<float, std::uint32_t> &b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+  };
+  n = std::min(n, keys_.size());
+  if (order != Order::kPid) {
+    if (n < keys_.size()) {
+      std::nth_element(keys_.begin(), keys_.begin() + n, keys_.end(),
+                       higher);
+    }
+    std::sort(keys_.begin(), keys_.begin() + n, higher);
+  }
+
+  top_.clear();
+  for (std::size_t i = 0; i < n; i++) {
+    top_.push_back(keys_[i].second);
+  }
+  return top_;
+}
+
+#endif
@@ -1,16 +1,57 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <vector>
+
+#include "linux_parser.h"
+
+/**
+ * @brief CPU time split over one sampling interval, every field is a
+ * fraction of the jiffies elapsed on that CPU during the interval
+ */
+struct CpuLoad_t {
+  float user = 0;   // user + nice
+  float system = 0; // system + irq + softirq
+  float iowait = 0;
+  float steal = 0;
+  float total = 0;  // every non idle state
+};
+
 class Processor {
 public:
   /**
-   * @brief Returns the CPU utilization
+   * @brief Returns the CPU utilization over the last sampling interval
    *
    * @return {float} : CPU utilization in fraction
    */
   float Utilization();
+  /**
+   * @brief Returns the aggregate CPU time split over the last interval
+   *
+   * @return {const CpuLoad_t&} : Load of all the CPUs together
+   */
+  const CpuLoad_t &Load() const;
+  /**
+   * @brief Returns the CPU time split of every logical core (cpu0..cpuN)
+   * over the last interval
+   *
+   * @return {const std::vector<CpuLoad_t>&} : One entry per core
+   */
+  const std::vector<CpuLoad_t> &Cores() const;
+  /**
+   * @brief Computes the load over the interval elapsed since the previous
+   * snapshot then keeps the new snapshot for the next call.
+   * On the first call the interval starts at boot.
+   *
+   * @param snapshot : Snapshot read by System for this tick
+   */
+  void Update(const LinuxParser::StatSnapshot_t &snapshot);
 
 private:
+  LinuxParser::CpuTimes_t prev_;
+  std::vector<LinuxParser::CpuTimes_t> prevCores_;
+  CpuLoad_t load_;
+  std::vector<CpuLoad_t> cores_;
 };
 
-#endif
\ No newline at end of file
+#endif
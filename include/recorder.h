@@ -0,0 +1,90 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "recording.h"
+#include "snapshot.h"
+
+/*
+Appends snapshots to an mmap-backed recording, see recording.h.
+The file is grown by kGrowStep and remapped, the blocks of the data
+area are allocated with posix_fallocate as it grows and those of the
+index a page at a time, so a full disk fails Append instead of raising
+SIGBUS. Each tick is then copied into the mapping, no formatted I/O is
+done while recording.
+*/
+class Recorder {
+public:
+  Recorder() = default;
+  /**
+   * @brief Closes the recording
+   */
+  ~Recorder();
+  Recorder(const Recorder &) = delete;
+  Recorder &operator=(const Recorder &) = delete;
+
+  /**
+   * @brief Creates the recording, an existing file is replaced
+   *
+   * @param path : Path of the recording
+   * @return {bool} : false if the file could not be created or mapped
+   */
+  bool Open(const std::string &path);
+  /**
+   * @brief Appends one tick to the recording
+   *
+   * @param snapshot : Tick to append
+   * @return {bool} : false if the recording is not open, is full or
+   * could not be grown
+   */
+  bool Append(const Snapshot_t &snapshot);
+  /**
+   * @brief Returns whether the index holds as many ticks as it can
+   *
+   * @return {bool} : true if Append fails for lack of index entries
+   */
+  bool Full() const;
+  /**
+   * @brief Trims the unused tail of the file, unmaps and closes it
+   */
+  void Close();
+
+private:
+  // Bytes added to the file each time the mapping is full
+  static constexpr std::uint64_t kGrowStep = 64 * 1024 * 1024;
+  // Index blocks are allocated this many bytes at a time, a page of
+  // entries
+  static constexpr std::uint64_t kIndexBlock = 4096;
+
+  /**
+   * @brief Grows the file and the mapping to hold at least size bytes,
+   * the blocks of the data area are allocated, the index is left sparse
+   *
+   * @param size : Bytes needed from the start of the file
+   * @return {bool} : false if the file could not be grown or its blocks
+   * allocated (disk full)
+   */
+  bool Reserve(std::uint64_t size);
+  /**
+   * @brief Allocates the blocks of a range of the file before it is
+   * written through the mapping: a hole written once the disk is full
+   * raises SIGBUS instead of failing here
+   *
+   * @param offset : Start of the range
+   * @param length : Length of the range
+   * @return {bool} : false if the blocks could not be allocated, errno
+   * is set
+   */
+  bool Allocate(std::uint64_t offset, std::uint64_t length);
+  Recording::Header_t *Header() const;
+
+  int fd_{-1};
+  char *map_{nullptr};
+  std::uint64_t mapSize_{0};
+  std::uint64_t dataOffset_{0}; // blocks before it are allocated on use
+};
+
+#endif
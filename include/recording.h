@@ -0,0 +1,88 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <cstdint>
+
+#include "processor.h"
+
+/*
+On-disk layout of a session recorded with --record.
+
+  [Header_t, padded to kHeaderSize]
+  [IndexEntry_t x indexCapacity]   one entry per tick, sorted by time
+  [tick 0][tick 1]...              TickRecord_t, cores, process rows
+
+Every record is a fixed-layout POD written with memcpy into the mapping,
+in host byte order. A tick is committed by writing its data, then its
+index entry, then bumping Header_t::tickCount, so a recording cut short
+by a crash stays readable up to its last complete tick.
+*/
+namespace Recording {
+
+constexpr char kMagic[8] = {'M', 'O', 'N', 'R', 'E', 'C', '\0', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint64_t kHeaderSize = 4096;
+// About 12 days at one tick per second. The 16 MiB index area is a sparse
+// hole, the recorder allocates its blocks a page (256 ticks) at a time
+constexpr std::uint64_t kIndexCapacity = 1 << 20;
+
+struct Header_t {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+  std::uint64_t indexOffset;
+  std::uint64_t indexCapacity;
+  std::uint64_t dataOffset;
+  std::uint64_t dataEnd;   // end of the last committed tick
+  std::uint64_t tickCount; // committed ticks
+  // CLOCK_REALTIME - CLOCK_MONOTONIC when the recording was created,
+  // turns the monotonic tick times into wall clock times
+  std::int64_t wallClockOffsetNs;
+  char operatingSystem[128];
+  char kernel[64];
+};
+
+struct IndexEntry_t {
+  std::int64_t timeNs;  // Snapshot_t::sampledAtNs
+  std::uint64_t offset; // of the TickRecord_t from the start of the file
+};
+
+struct TickRecord_t {
+  std::uint64_t tick;
+  std::int64_t timeNs;
+  std::int64_t jitterNs;
+  CpuLoad_t cpu;
+  float memory;
+  std::int32_t totalProcesses;
+  std::int32_t runningProcesses;
+  std::int64_t uptime;
+  std::uint32_t coreCount;    // CpuLoad_t following the record
+  std::uint32_t processCount; // ProcessRecord_t following the cores
+};
+
+struct ProcessRecord_t {
+  std::int32_t pid;
+  float cpu;
+  std::int64_t ramMb; // -1 when unknown (zombie)
+  std::int64_t uptime;
+  char user[32];      // truncated, NUL terminated
+  char command[128];  // truncated, NUL terminated
+};
+
+/**
+ * @brief Returns the size of a tick once written
+ *
+ * @param coreCount : Number of cores of the tick
+ * @param processCount : Number of process rows of the tick
+ * @return {uint64_t} : Size in bytes, records stay 8 bytes aligned
+ */
+inline std::uint64_t TickSize(std::uint64_t coreCount,
+                              std::uint64_t processCount) {
+  std::uint64_t size = sizeof(TickRecord_t) + coreCount * sizeof(CpuLoad_t);
+  size = (size + 7) & ~std::uint64_t(7);
+  return size + processCount * sizeof(ProcessRecord_t);
+}
+
+} // namespace Recording
+
+#endif
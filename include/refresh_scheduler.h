@@ -0,0 +1,68 @@
+#ifndef REFRESH_SCHEDULER_H
+#define REFRESH_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "process_table.h"
+
+/*
+Decides which processes get their /proc/pid/stat read on a tick.
+Processes fall in three tiers from their recent activity: hot ones were
+active on their last read and are read every tick, warm ones have been
+idle for less than kColdTicks and are read every few ticks, cold ones
+only every kPeriods[kCold] ticks. Reads of a tier are spread over its
+period by pid so they do not all land on the same tick.
+A process is promoted to hot as soon as a read shows activity. Since a
+cold process waking up could stay unread for a while, the procs_running
+counter of /proc/stat is compared with the runnable threads the table
+accounts for: if more tasks are running than the table knows of, every
+process is read on that tick. The monitor itself is left out of both
+sides, the thread sampling /proc/stat is always running.
+*/
+class RefreshScheduler {
+public:
+  enum Tier { kHot, kWarm, kCold, kTiers };
+  // Ticks between two stat reads of a process of each tier
+  static constexpr unsigned kPeriods[kTiers]{1, 4, 16};
+  // Idle ticks after which a warm process becomes cold
+  static constexpr unsigned kColdTicks{8};
+
+  /**
+   * @brief Returns the tier of a row of the table
+   *
+   * @param table : Process table
+   * @param row : Row of the process
+   * @return {Tier} : Tier from the idle ticks of the row
+   */
+  static Tier Classify(const ProcessTable &table, std::size_t row);
+
+  /**
+   * @brief Plans the reads of one tick
+   *
+   * @param table : Process table of the previous tick
+   * @param pids : Live pids of this tick, ascending
+   * @param procsRunning : procs_running of /proc/stat for this tick
+   * @param self : Pid of the monitor when procsRunning was sampled by
+   * one of its threads, 0 otherwise (fixture)
+   * @param due : Receives, for each pid, whether its stat must be read
+   * @return {bool} : true if every pid is due (activity unaccounted for)
+   */
+  bool Plan(const ProcessTable &table, const std::vector<int> &pids,
+            int procsRunning, int self, std::vector<unsigned char> &due);
+
+  /**
+   * @brief Returns the number of processes of each tier at the last Plan
+   *
+   * @param tier : Tier
+   * @return {size_t} : Processes of the tier, new pids count as hot
+   */
+  std::size_t Count(Tier tier) const { return counts_[tier]; }
+
+private:
+  std::uint64_t tick_{0};
+  std::size_t counts_[kTiers]{};
+};
+
+#endif
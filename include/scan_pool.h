@@ -0,0 +1,89 @@
+#ifndef SCAN_POOL_H
+#define SCAN_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Fixed pool of worker threads used to scan /proc in parallel.
+ParallelFor splits the index range into one slice per worker. A worker
+claims small chunks from its own slice first, then steals chunks from the
+slices of the other workers, so uneven per-pid costs (zombies, huge
+cmdlines) do not leave workers idle. Claims are a single fetch_add on the
+slice cursor, no lock is taken while the work runs.
+*/
+class ScanPool {
+public:
+  /**
+   * @brief Construct a new ScanPool object
+   * The calling thread takes part in the work, so workers - 1 threads
+   * are started.
+   *
+   * @param workers : Number of workers, at least 1
+   */
+  explicit ScanPool(unsigned workers);
+  /**
+   * @brief Stops and joins the worker threads
+   */
+  ~ScanPool();
+  ScanPool(const ScanPool &) = delete;
+  ScanPool &operator=(const ScanPool &) = delete;
+
+  /**
+   * @brief Returns the number of workers, calling thread included
+   *
+   * @return {unsigned} : Number of workers
+   */
+  unsigned Workers() const;
+  /**
+   * @brief Runs task(worker, index) for every index of [0, count) and
+   * returns once all of them are done. The worker number is in
+   * [0, Workers()) and lets the task write to a per-worker shard.
+   *
+   * @param count : Number of indexes
+   * @param task : Work for one index
+   */
+  void ParallelFor(std::size_t count,
+                   const std::function<void(unsigned, std::size_t)> &task);
+
+private:
+  // Indexes claimed at once, small enough to balance, large enough to
+  // keep the cursors cold
+  static constexpr std::size_t kChunk{16};
+
+  struct alignas(64) Slice_t {
+    std::atomic<std::size_t> next{0};
+    std::size_t end{0};
+  };
+
+  /**
+   * @brief Body of the background workers
+   *
+   * @param worker : Worker number
+   */
+  void Run(unsigned worker);
+  /**
+   * @brief Claims and runs chunks, own slice first then the others
+   *
+   * @param worker : Worker number
+   */
+  void Work(unsigned worker);
+
+  std::vector<Slice_t> slices_;
+  std::vector<std::thread> threads_;
+  const std::function<void(unsigned, std::size_t)> *task_{nullptr};
+
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  std::size_t generation_{0};
+  unsigned pending_{0};
+  bool stopping_{false};
+};
+
+#endif
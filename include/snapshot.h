@@ -0,0 +1,76 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "proc_events.h"
+#include "processor.h"
+#include "tick_profiler.h"
+
+/*
+Immutable copy of everything the display shows for one tick.
+Snapshots are produced by the Collector thread and only read afterwards,
+so the render loop never touches /proc.
+*/
+
+/**
+ * @brief One row of the process window
+ */
+struct ProcessRow_t {
+  int pid = 0;
+  std::string user;
+  float cpu = 0;   // fraction of one CPU over the last interval
+  // From /proc/pid/statm in kB, -1 without an address space (kernel
+  // thread, zombie) or when unknown
+  long ramKb = -1;    // resident set size
+  long sharedKb = -1; // resident file-backed and shared pages
+  long textKb = -1;   // code
+  // From /proc/pid/smaps_rollup in kB when the memory sampler runs, -1
+  // until sampled. The sampler refreshes a few processes per tick, so
+  // the values are memoryAge seconds old (-1 if never read).
+  long pssKb = -1;
+  long ussKb = -1;
+  float memoryAge = -1;
+  // From /proc/pid/io when I/O is sampled, per second over the last
+  // interval; -1 when not sampled or the io file is denied
+  long readBps = -1;  // bytes read from storage
+  long writeBps = -1; // bytes written to storage
+  float syscrPs = -1; // read syscalls
+  float syscwPs = -1; // write syscalls
+  long cancelledWriteBytes = -1; // since the process started
+  long uptime = 0; // seconds
+  std::string command;
+};
+
+/**
+ * @brief System counters and top processes of one tick
+ */
+struct Snapshot_t {
+  std::uint64_t tick = 0;
+  // Monotonic time of the sample and its delay past the scheduled time
+  std::int64_t sampledAtNs = 0;
+  std::int64_t jitterNs = 0;
+
+  std::string operatingSystem;
+  std::string kernel;
+  CpuLoad_t cpu;
+  std::vector<CpuLoad_t> cores;
+  float memory = 0;
+  int totalProcesses = 0;
+  int runningProcesses = 0;
+  long uptime = 0;
+  std::vector<ProcessRow_t> processes;
+  // PSS/USS sampled, see MemorySampler
+  bool memorySampled = false;
+  // I/O rates sampled, see System::SampleIo
+  bool ioSampled = false;
+  // Processes that exited since the previous tick (proc connector only)
+  std::vector<ExitRecord_t> exited;
+  std::uint64_t exitsDropped = 0;
+  // Cost of sampling, not stored in recordings
+  TickProfile_t profile;
+};
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef STAT_PARSER_H
+#define STAT_PARSER_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+#include "linux_parser.h"
+
+/*
+Field-selective parser for /proc/pid/stat.
+The fields wanted are template parameters, in ascending order. Parse walks
+the record once: fields in between are skipped without being decoded and
+it stops right after the highest field wanted, so a caller asking for the
+starttime never tokenizes the 30 fields that follow it. Values land in a
+fixed-layout Record_t, read back with Get<Field>().
+*/
+namespace LinuxParser {
+
+// Fields of /proc/pid/stat, numbered from 1 as in proc(5)
+enum class Field {
+  kComm = 2,
+  kState = 3,
+  kPpid = 4,
+  kMinflt = 10,
+  kMajflt = 12,
+  kUtime = 14,
+  kStime = 15,
+  kCutime = 16,
+  kCstime = 17,
+  kPriority = 18,
+  kNice = 19,
+  kNumThreads = 20,
+  kStarttime = 22,
+  kVsize = 23,
+  kRss = 24,
+  kProcessor = 39
+};
+
+/**
+ * @brief Type a field is decoded into, counters are unsigned by default
+ */
+template <Field F> struct FieldType { using type = unsigned long; };
+template <> struct FieldType<Field::kComm> {
+  // At most 15 characters, kept NUL terminated
+  using type = std::array<char, 16>;
+};
+template <> struct FieldType<Field::kState> { using type = char; };
+template <> struct FieldType<Field::kPpid> { using type = int; };
+template <> struct FieldType<Field::kCutime> { using type = long; };
+template <> struct FieldType<Field::kCstime> { using type = long; };
+template <> struct FieldType<Field::kPriority> { using type = long; };
+template <> struct FieldType<Field::kNice> { using type = long; };
+template <> struct FieldType<Field::kNumThreads> { using type = long; };
+template <> struct FieldType<Field::kStarttime> {
+  using type = unsigned long long;
+};
+template <> struct FieldType<Field::kRss> { using type = long; };
+template <> struct FieldType<Field::kProcessor> { using type = int; };
+
+/**
+ * @brief Parses the next space separated integer in [first, last)
+ * and advances first past it
+ *
+ * @param first : Start of the text, updated on success
+ * @param last : End of the text
+ * @param value : Parsed value
+ * @return {bool} : true if a number was parsed
+ */
+template <typename T>
+inline bool ParseNumber(const char *&first, const char *last, T &value) {
+  while (first != last && *first == ' ') {
+    ++first;
+  }
+  auto result = std::from_chars(first, last, value);
+  if (result.ec != std::errc()) {
+    return false;
+  }
+  first = result.ptr;
+  return true;
+}
+
+/**
+ * @brief Parses the next space separated character in [first, last)
+ * and advances first past it
+ */
+inline bool ParseNumber(const char *&first, const char *last, char &value) {
+  while (first != last && *first == ' ') {
+    ++first;
+  }
+  if (first == last) {
+    return false;
+  }
+  value = *first++;
+  return true;
+}
+
+/**
+ * @brief Skips the next space separated field in [first, last)
+ *
+ * @param first : Start of the text, updated on success
+ * @param last : End of the text
+ * @return {bool} : true if a field was skipped
+ */
+inline bool SkipField(const char *&first, const char *last) {
+  while (first != last && *first == ' ') {
+    ++first;
+  }
+  const char *end = std::find(first, last, ' ');
+  if (end == first) {
+    return false;
+  }
+  first = end;
+  return true;
+}
+
+template <Field... Fields> class StatParser {
+public:
+  static_assert(sizeof...(Fields) > 0, "StatParser needs a field");
+
+  /**
+   * @brief Values of the fields wanted, in template order
+   */
+  struct Record_t {
+    std::tuple<typename FieldType<Fields>::type...> values{};
+
+    template <Field F> typename FieldType<F>::type &Get() {
+      return std::get<IndexOf(F)>(values);
+    }
+    template <Field F> const typename FieldType<F>::type &Get() const {
+      return std::get<IndexOf(F)>(values);
+    }
+  };
+
+  /**
+   * @brief Decodes the fields wanted from the text of a stat file.
+   * Fields are located after the last ')' so a comm holding spaces or
+   * parentheses does not shift them.
+   *
+   * @param first : Start of the text
+   * @param last : End of the text
+   * @param record : Record to fill
+   * @return {bool} : false if the record is truncated or malformed
+   */
+  static bool Parse(const char *first, const char *last, Record_t &record) {
+    const char *commEnd =
+        static_cast<const char *>(memrchr(first, ')', last - first));
+    const char *commStart =
+        static_cast<const char *>(memchr(first, '(', last - first));
+    if (commEnd == nullptr || commStart == nullptr || commStart > commEnd) {
+      return false;
+    }
+    /* The comm field is the only one before the closing parenthesis */
+    int field = int(Field::kState);
+    first = commEnd + 1;
+    return ParseFields(commStart + 1, commEnd, first, last, field, record,
+                       std::make_index_sequence<sizeof...(Fields)>{});
+  }
+
+  /**
+   * @brief Reads /proc/pid/stat with a single read() into a stack buffer
+   * and decodes the fields wanted, without any heap allocation
+   *
+   * @param pid : Process ID
+   * @param record : Record to fill
+   * @return {bool} : false if the process is gone or the file is truncated
+   */
+  static bool Read(int pid, Record_t &record) {
+    char buffer[1024];
+    std::size_t size = 0;
+    if (!ReadPidFile(pid, kStatFilename, buffer, sizeof(buffer), size)) {
+      return false;
+    }
+    return Parse(buffer, buffer + size, record);
+  }
+
+private:
+  static constexpr Field kFields[] = {Fields...};
+
+  static constexpr bool Ascending() {
+    for (std::size_t i = 1; i < sizeof...(Fields); i++) {
+      if (int(kFields[i - 1]) >= int(kFields[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  static_assert(Ascending(), "StatParser fields must be ascending");
+
+  static constexpr std::size_t IndexOf(Field field) {
+    std::size_t i = 0;
+    while (i < sizeof...(Fields) && kFields[i] != field) {
+      i++;
+    }
+    return i;
+  }
+
+  template <std::size_t... I>
+  static bool ParseFields(const char *comm, const char *commEnd,
+                          const char *&first, const char *last, int &field,
+                          Record_t &record, std::index_sequence<I...>) {
+    /* Unrolled at compile time, && stops at the first failure */
+    return (ParseField<kFields[I]>(comm, commEnd, first, last, field,
+                                   std::get<I>(record.values)) &&
+            ...);
+  }
+
+  template <Field F, typename T>
+  static bool ParseField(const char *comm, const char *commEnd,
+                         const char *&first, const char *last, int &field,
+                         T &value) {
+    if constexpr (F == Field::kComm) {
+      std::size_t length =
+          std::min<std::size_t>(commEnd - comm, value.size() - 1);
+      memcpy(value.data(), comm, length);
+      value[length] = '\0';
+      return true;
+    } else {
+      for (; field < int(F); field++) {
+        if (!SkipField(first, last)) {
+          return false;
+        }
+      }
+      field++;
+      return ParseNumber(first, last, value);
+    }
+  }
+};
+
+} // namespace LinuxParser
+
+#endif
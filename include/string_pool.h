@@ -0,0 +1,75 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+Process-wide pool of interned strings.
+ProcessTable rows sharing the same command line or user share one copy
+of the text, each row holds one reference taken by Intern and dropped
+by Release when the row is retired, the text is freed with the last one. The pool has a hard cap on the bytes it holds,
+once reached Intern refuses new strings and callers read them uncached.
+*/
+class StringPool {
+public:
+  // Id returned when a string could not be interned
+  static constexpr std::uint32_t kNone = UINT32_MAX;
+  // Longer strings are truncated before being interned
+  static constexpr std::size_t kMaxLength = 4096;
+  // Hard cap on the text held by the pool
+  static constexpr std::size_t kMaxBytes = 16 * 1024 * 1024;
+
+  /**
+   * @brief Returns the pool shared by the whole process
+   *
+   * @return {StringPool&} : The process-wide instance
+   */
+  static StringPool &Instance();
+  /**
+   * @brief Returns the id of the text, adding it to the pool if needed.
+   * The caller owns one reference on the returned id.
+   *
+   * @param text : Text to intern, truncated to kMaxLength
+   * @return {uint32_t} : Id of the text, kNone if the pool is full
+   */
+  std::uint32_t Intern(std::string_view text);
+  /**
+   * @brief Drops a reference on an id, the text is freed with the last one
+   *
+   * @param id : Id returned by Intern, kNone is ignored
+   */
+  void Release(std::uint32_t id);
+  /**
+   * @brief Returns the text of an id
+   * The reference stays valid as long as the caller holds the id.
+   *
+   * @param id : Id returned by Intern
+   * @return {const std::string&} : The interned text
+   */
+  const std::string &Get(std::uint32_t id);
+
+private:
+  struct Entry_t {
+    std::string text;
+    std::uint32_t refs = 0;
+  };
+
+  StringPool() = default;
+  static std::size_t Cost(const std::string &text);
+
+  /* deque keeps the entries in place so the index can point into them */
+  std::deque<Entry_t> entries_;
+  std::vector<std::uint32_t> free_;
+  std::unordered_map<std::string_view, std::uint32_t> index_;
+  std::size_t bytes_ = 0;
+  std::mutex mutex_;
+};
+
+#endif
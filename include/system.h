@@ -1,12 +1,21 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "linux_parser.h"
-#include "process.h"
+#include "memory_sampler.h"
+#include "proc_events.h"
+#include "process_table.h"
 #include "processor.h"
+#include "refresh_scheduler.h"
+#include "scan_pool.h"
+#include "tick_profiler.h"
 class System {
 public:
   /**
@@ -16,17 +25,97 @@ public:
    */
   Processor &Cpu();                 
   /**
-   * @brief reutrns the system's processes ordered by CPU utilization
+   * @brief Refreshes and returns the system's processes
+   * The table lives across ticks: survivors only have their counters
+   * refreshed, new pids are inserted and dead ones are retired.
    * 
-   * @return vector<Process>& 
+   * @return ProcessTable& 
    */
-  std::vector<Process> &Processes(); 
+  ProcessTable &Processes();
+  /**
+   * @brief Returns the rows of the n processes ranked first by the order
+   * of SortBy (CPU utilization by default) in the last Processes()
+   * refresh, highest first
+   *
+   * @param n : Number of processes wanted
+   * @return {const vector<size_t>&} : Rows of the process table, valid
+   * until the next call to Processes()
+   */
+  const std::vector<std::size_t> &TopProcesses(std::size_t n);
+  /**
+   * @brief Returns the processes that exited since the previous
+   * Processes() refresh, only known when events are active
+   *
+   * @return {const vector<ExitRecord_t>&} : Exits in the order they
+   * happened
+   */
+  const std::vector<ExitRecord_t> &Exited() const;
+  /**
+   * @brief Returns the number of exits missing from Exited() because
+   * too many happened within one tick
+   *
+   * @return {uint64_t} : Exits dropped during the last refresh
+   */
+  std::uint64_t ExitsDropped() const;
+  /**
+   * @brief Returns whether pids come from the proc connector
+   *
+   * @return {bool} : false if every tick scans /proc
+   */
+  bool EventsActive() const;
+  /**
+   * @brief Samples the PSS and USS of the processes after every refresh
+   * of the table, see MemorySampler
+   *
+   * @param budget : CPU time the sampler may spend per tick
+   * @param top : Number of processes with the highest RSS refreshed
+   * every tick
+   */
+  void SampleMemory(std::chrono::microseconds budget, std::size_t top);
+  /**
+   * @brief Returns whether PSS and USS are sampled
+   *
+   * @return {bool} : true after SampleMemory
+   */
+  bool MemorySampled() const;
+  /**
+   * @brief Reads /proc/pid/io along with the stat of each process so the
+   * table holds its I/O rates. Processes whose io file is denied are not
+   * read again until their pid is reused.
+   */
+  void SampleIo();
+  /**
+   * @brief Returns whether I/O rates are sampled
+   *
+   * @return {bool} : true after SampleIo
+   */
+  bool IoSampled() const;
+  /**
+   * @brief Sets the order TopProcesses ranks processes by
+   *
+   * @param order : ProcessTable::Order::kIo needs SampleIo
+   */
+  void SortBy(ProcessTable::Order order);
   /**
    * @brief Construct a new System:: System object
-   * The constructor retrieves the list of process ids
-   * and fills the processes_ attributes
+   * The constructor reads the first /proc/stat snapshot and fills
+   * the process table
+   *
+   * @param workers : Number of threads scanning /proc/pid
+   * @param events : Follow forks and exits with the proc connector
+   * instead of listing /proc every tick, full scans are kept if the
+   * connector is unavailable
+   * @param tiered : Read the stat of idle processes less often, see
+   * RefreshScheduler, instead of reading every process every tick
    */
-  System();
+  explicit System(unsigned workers = 1, bool events = false,
+                  bool tiered = true);
+  /**
+   * @brief Reads /proc/stat once for this tick and hands the snapshot
+   * to the CPU and the process counters. Must be called once per frame
+   * before querying the system.
+   */
+  void Refresh();
 
   /**
    * @brief Returns the system's memory utilization.
@@ -42,15 +131,15 @@ public:
   long int UpTime();
 
   /**
-   * @brief Return the total number of processes by calling
-   * LinuxParser::TotalProcesses()
+   * @brief Return the total number of processes from the
+   * /proc/stat snapshot of the current tick
    *
    * @return {int} : The total number of processes as an integer.
    */
   int TotalProcesses();
   /**
    * @brief This function returns the number of running processes
-   * by calling LinuxParser::RunningProcesses()
+   * from the /proc/stat snapshot of the current tick
    *
    * @return {int} number of running processes
    */
@@ -69,15 +158,67 @@ public:
    * @return {string} : The operating system name as a string.
    */
   std::string OperatingSystem();
+  /**
+   * @brief Returns the profiler timing the stages of each tick
+   *
+   * @return {TickProfiler&} : Profiler of this system, thread safe
+   */
+  TickProfiler &Profiler();
 
 private:
   Processor cpu_ = {};
-  std::vector<Process> processes_ = {};
+  // Declared before table_ which keeps a reference on it
+  TickProfiler profiler_;
+  ProcessTable table_;
+  /**
+   * @brief Pids listed by the last refresh, kept for its capacity
+   */
+  std::vector<int> pids_;
+  /**
+   * @brief /proc/pid/stat of pids_[i] and whether it could be read,
+   * filled in parallel by the scan pool
+   */
+  std::vector<ProcessTable::Stat_t> stats_;
+  std::vector<unsigned char> read_;
+  /**
+   * @brief Whether the stat of pids_[i] is read this tick
+   */
+  std::vector<unsigned char> due_;
+  /**
+   * @brief /proc/pid/io of pids_[i] and how its read went, one of
+   * IoRead values, only filled when io_ is set
+   */
+  enum IoRead : unsigned char { kIoSkipped, kIoRead, kIoDenied };
+  std::vector<LinuxParser::ProcIo_t> ios_;
+  std::vector<IoRead> ioRead_;
+  bool io_{false};
+  ProcessTable::Order order_{ProcessTable::Order::kCpu};
+  ScanPool pool_;
+  RefreshScheduler scheduler_;
+  bool tiered_;
+  /**
+   * @brief Time of the previous process table refresh
+   */
+  std::chrono::steady_clock::time_point lastTick_;
+  /**
+   * @brief /proc/stat counters of the current tick
+   */
+  LinuxParser::StatSnapshot_t stat_;
   /**
    * @brief structure for holding memory usage
    * data
    */
   LinuxParser::MemoryUtilData_t memoryUtilData_;
+  /**
+   * @brief Proc connector listener, null when /proc is scanned
+   */
+  std::unique_ptr<ProcEvents> events_;
+  /**
+   * @brief PSS/USS sampler, null unless SampleMemory was called
+   */
+  std::unique_ptr<MemorySampler> sampler_;
+  std::vector<ExitRecord_t> exited_;
+  std::uint64_t exitsDropped_{0};
 };
 
 #endif
\ No newline at end of file
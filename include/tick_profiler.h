@@ -0,0 +1,112 @@
+#ifndef TICK_PROFILER_H
+#define TICK_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/*
+Measures the monitor's own hot path.
+Each stage of a tick adds the wall time it spent, several calls within
+one tick are summed. EndTick closes the tick: the sums and the number of
+syscalls made since the previous tick are pushed into rolling windows of
+the last kWindow ticks, from which p50/p99/max are computed.
+Stages may be timed from any thread (rendering runs on the UI thread).
+*/
+
+enum class TickStage { kPids, kStat, kStatus, kUser, kSmaps, kSort, kRender };
+constexpr std::size_t kTickStages{7};
+
+/**
+ * @brief Last value and rolling percentiles of one measure
+ */
+struct Percentiles_t {
+  std::int64_t last = 0;
+  std::int64_t p50 = 0;
+  std::int64_t p99 = 0;
+  std::int64_t max = 0;
+};
+
+/**
+ * @brief Per-stage wall time in ns and syscalls per tick
+ * Syscalls are the read/write class calls of the whole process counted
+ * by /proc/self/io (syscr + syscw).
+ */
+struct TickProfile_t {
+  Percentiles_t stages[kTickStages];
+  Percentiles_t syscalls;
+};
+
+class TickProfiler {
+public:
+  static constexpr std::size_t kWindow{512};
+
+  /**
+   * @brief Adds the lifetime of the object to a stage
+   */
+  class Timer {
+  public:
+    Timer(TickProfiler &profiler, TickStage stage)
+        : profiler_(profiler), stage_(stage),
+          start_(std::chrono::steady_clock::now()) {}
+    ~Timer() {
+      profiler_.Add(stage_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - start_)
+                                .count());
+    }
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+  private:
+    TickProfiler &profiler_;
+    TickStage stage_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  TickProfiler();
+  /**
+   * @brief Adds time spent in a stage to the current tick
+   *
+   * @param stage : Stage measured
+   * @param ns : Wall time in nanoseconds
+   */
+  void Add(TickStage stage, std::int64_t ns);
+  /**
+   * @brief Closes the current tick and pushes its measures into the
+   * rolling windows
+   */
+  void EndTick();
+  /**
+   * @brief Returns the last tick and the percentiles of the window
+   *
+   * @return {TickProfile_t} : Profile of the last kWindow ticks
+   */
+  TickProfile_t Profile() const;
+  /**
+   * @brief Returns the short name of a stage
+   *
+   * @param stage : Stage
+   * @return {const char *} : "pids", "stat", "status", "user", "sort"
+   * or "render"
+   */
+  static const char *StageName(TickStage stage);
+
+private:
+  /* Ring of the last kWindow values */
+  struct Window_t {
+    std::array<std::int64_t, kWindow> values{};
+    std::size_t count = 0;
+    void Push(std::int64_t value);
+    Percentiles_t Summary() const;
+  };
+
+  mutable std::mutex mutex_;
+  std::int64_t current_[kTickStages]{};
+  Window_t stages_[kTickStages];
+  Window_t syscalls_;
+  std::uint64_t lastSyscalls_{0};
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <time.h>
+#include <vector>
+
+/*
+Process-wide uid -> user name table.
+It is built once from /etc/passwd and rebuilt only when the file is
+replaced or modified (inode, size or mtime change). Uids missing from the
+file (NSS/LDAP users) are resolved with getpwuid_r, outside the lock
+since it may wait on the network, and kept in the table.
+*/
+class UserCache {
+public:
+  /**
+   * @brief Returns the table shared by the whole process
+   *
+   * @return {UserCache&} : The process-wide instance
+   */
+  static UserCache &Instance();
+  /**
+   * @brief Returns the user name associated with the uid
+   * If no name can be found the uid itself is returned as a string.
+   *
+   * @param uid : User ID
+   * @return {string} : User name associated with the uid
+   */
+  std::string Lookup(uid_t uid);
+
+private:
+  /* Open addressing table with linear probing, capacity is a power of 2 */
+  struct Slot_t {
+    uid_t uid = 0;
+    bool used = false;
+    std::uint32_t name = 0; // index in names_
+  };
+
+  UserCache() = default;
+  /**
+   * @brief Rebuilds the table if /etc/passwd changed since it was loaded
+   * The file is checked at most once per kRecheckPeriod.
+   */
+  void Revalidate();
+  /**
+   * @brief Clears the table and fills it from /etc/passwd
+   */
+  void Load();
+  /**
+   * @brief Resolves a uid missing from /etc/passwd through NSS
+   *
+   * @param uid : User ID
+   * @return {string} : User name, or the uid as a string if unknown
+   */
+  static std::string Resolve(uid_t uid);
+  /**
+   * @brief Adds the name of a uid, the first entry of a uid wins
+   *
+   * @param uid : User ID
+   * @param name : User name
+   */
+  void Insert(uid_t uid, std::string name);
+  /**
+   * @brief Finds the slot holding the uid
+   *
+   * @param uid : User ID
+   * @return {const Slot_t*} : The slot or nullptr if the uid is not cached
+   */
+  const Slot_t *Find(uid_t uid) const;
+  /**
+   * @brief Doubles the capacity of the table and rehashes every entry
+   */
+  void Grow();
+
+  static constexpr std::chrono::seconds kRecheckPeriod{1};
+
+  std::vector<Slot_t> slots_;
+  std::vector<std::string> names_;
+
+  /* Identity of /etc/passwd when the table was loaded */
+  dev_t device_ = 0;
+  ino_t inode_ = 0;
+  off_t size_ = -1;
+  struct timespec mtime_ = {};
+  std::chrono::steady_clock::time_point lastCheck_;
+  bool loaded_ = false;
+
+  std::mutex mutex_;
+};
+
+#endif
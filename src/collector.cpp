@@ -0,0 +1,179 @@
+#include "collector.h"
+
+using std::chrono::steady_clock;
+
+/**
+ * @brief Construct a new Collector object
+ *
+ * @param system : System sampled, only touched by the collector thread
+ * once started
+ * @param n : Number of top processes kept in each snapshot
+ * @param period : Sampling period
+ */
+Collector::Collector(System &system, std::size_t n,
+                     std::chrono::milliseconds period)
+    : system_(system), n_(n), period_(period),
+      scheduled_(steady_clock::now()),
+      operatingSystem_(system.OperatingSystem()), kernel_(system.Kernel()) {}
+
+/**
+ * @brief Stops the sampling thread
+ */
+Collector::~Collector() { Stop(); }
+
+/**
+ * @brief Starts the sampling thread, the first tick is taken immediately
+ */
+void Collector::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return;
+  }
+  running_ = true;
+  scheduled_ = steady_clock::now();
+  thread_ = std::thread(&Collector::Run, this);
+}
+
+/**
+ * @brief Stops the sampling thread and waits for it to exit
+ */
+void Collector::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  wakeup_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+/**
+ * @brief Returns the most recent snapshot
+ *
+ * @return {std::shared_ptr<const Snapshot_t>} : Latest snapshot, null
+ * until the first tick is published
+ */
+std::shared_ptr<const Snapshot_t> Collector::Latest() const {
+  return std::atomic_load(&latest_);
+}
+
+/**
+ * @brief Refreshes the system and copies what is displayed into a new
+ * snapshot. Called by the sampling thread, can also be called directly
+ * when no thread is running.
+ *
+ * @return {std::shared_ptr<Snapshot_t>} : The new snapshot
+ */
+std::shared_ptr<Snapshot_t> Collector::Sample() {
+  auto snapshot = std::make_shared<Snapshot_t>();
+  auto now = steady_clock::now();
+
+  snapshot->tick = tick_++;
+  snapshot->sampledAtNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          now.time_since_epoch())
+          .count();
+  snapshot->jitterNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - scheduled_)
+          .count();
+
+  system_.Refresh();
+  snapshot->operatingSystem = operatingSystem_;
+  snapshot->kernel = kernel_;
+  snapshot->cpu = system_.Cpu().Load();
+  snapshot->cores = system_.Cpu().Cores();
+  snapshot->memory = system_.MemoryUtilization();
+  snapshot->totalProcesses = system_.TotalProcesses();
+  snapshot->runningProcesses = system_.RunningProcesses();
+  snapshot->uptime = system_.UpTime();
+
+  ProcessTable &table = system_.Processes();
+  snapshot->memorySampled = system_.MemorySampled();
+  snapshot->ioSampled = system_.IoSampled();
+  const std::vector<std::size_t> &top = system_.TopProcesses(n_);
+  snapshot->processes.reserve(top.size());
+  auto const sampled = steady_clock::now();
+  for (std::size_t r : top) {
+    ProcessRow_t row;
+    row.pid = table.Pid(r);
+    row.user = table.User(r);
+    row.cpu = table.CpuUtilization(r);
+    /* Kernel threads and zombies have no address space */
+    LinuxParser::Statm_t statm;
+    if (LinuxParser::ReadStatm(row.pid, statm) && statm.size > 0) {
+      row.ramKb = statm.resident;
+      row.sharedKb = statm.shared;
+      row.textKb = statm.text;
+    }
+    if (table.Pss(r) >= 0) {
+      row.pssKb = table.Pss(r);
+      row.ussKb = table.Uss(r);
+    }
+    if (table.MemorySampledAt(r) != steady_clock::time_point{}) {
+      row.memoryAge = std::chrono::duration<float>(
+                          sampled - table.MemorySampledAt(r))
+                          .count();
+    }
+    if (table.IoKnown(r)) {
+      const ProcessTable::IoRates_t &io = table.IoRates(r);
+      row.readBps = long(io.readBytes);
+      row.writeBps = long(io.writeBytes);
+      row.syscrPs = io.syscr;
+      row.syscwPs = io.syscw;
+      row.cancelledWriteBytes = long(table.CancelledWriteBytes(r));
+    }
+    row.uptime = table.UpTime(r);
+    row.command = table.Command(r);
+    snapshot->processes.push_back(std::move(row));
+  }
+
+  snapshot->exited = system_.Exited();
+  snapshot->exitsDropped = system_.ExitsDropped();
+
+  TickProfiler &profiler = system_.Profiler();
+  profiler.EndTick();
+  snapshot->profile = profiler.Profile();
+  return snapshot;
+}
+
+/**
+ * @brief Sets a function called on the sampling thread with every new
+ * snapshot, right after it is published. Must be set before Start.
+ *
+ * @param sink : Consumer of the snapshots
+ */
+void Collector::OnSample(std::function<void(const Snapshot_t &)> sink) {
+  sink_ = std::move(sink);
+}
+
+/**
+ * @brief Returns the profiler of the sampled system, the display adds
+ * its render time to it
+ *
+ * @return {TickProfiler&} : Profiler of the system, thread safe
+ */
+TickProfiler &Collector::Profiler() { return system_.Profiler(); }
+
+/**
+ * @brief Body of the sampling thread
+ */
+void Collector::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    lock.unlock();
+    std::shared_ptr<const Snapshot_t> snapshot = Sample();
+    std::atomic_store(&latest_, snapshot);
+    if (sink_) {
+      sink_(*snapshot);
+    }
+    lock.lock();
+
+    /* Next slot on the fixed grid, missed slots are skipped */
+    auto now = steady_clock::now();
+    do {
+      scheduled_ += period_;
+    } while (scheduled_ <= now);
+    wakeup_.wait_until(lock, scheduled_, [this] { return !running_; });
+  }
+}
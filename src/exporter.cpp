@@ -0,0 +1,382 @@
+#include "exporter.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Construct a new Exporter object
+ *
+ * @param format : Output format
+ * @param out : Stream written to, not closed by the exporter
+ * @param profile : Also write the tick profile (stage timings and
+ * syscalls)
+ */
+Exporter::Exporter(ExportFormat format, FILE *out, bool profile)
+    : format_(format), out_(out), profile_(profile) {
+  buffer_.reserve(64 * 1024);
+}
+
+/**
+ * @brief Parses a format name
+ *
+ * @param name : "ndjson" or "csv"
+ * @param format : Parsed format
+ * @return {bool} : false if the name is unknown
+ */
+bool Exporter::ParseFormat(std::string_view name, ExportFormat &format) {
+  if (name == "ndjson") {
+    format = ExportFormat::kNdjson;
+  } else if (name == "csv") {
+    format = ExportFormat::kCsv;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes the record of one tick and flushes the stream
+ *
+ * @param snapshot : Tick to write
+ * @return {bool} : false if the stream could not be written
+ */
+bool Exporter::Write(const Snapshot_t &snapshot) {
+  /* clear() keeps the capacity reached by the previous ticks */
+  buffer_.clear();
+  if (format_ == ExportFormat::kNdjson) {
+    FormatNdjson(snapshot);
+  } else {
+    FormatCsv(snapshot);
+  }
+
+  bool written =
+      fwrite(buffer_.data(), 1, buffer_.size(), out_) == buffer_.size();
+  return fflush(out_) == 0 && written;
+}
+
+/*
+{"tick":1,"time_ns":..,"jitter_ns":..,
+ "cpu":{"total":..,"user":..,"system":..,"iowait":..,"steal":..},
+ "cores":[..],"memory":..,"processes_total":..,"processes_running":..,
+ "uptime":..,"processes":[{"pid":..,"user":"..","cpu":..,"ram_mb":..,
+ "rss_kb":..,"shared_kb":..,"text_kb":..,"pss_kb":..,"uss_kb":..,
+ "memory_age":..,"read_bps":..,"write_bps":..,"syscr_ps":..,
+ "syscw_ps":..,"cancelled_write_bytes":..,"uptime":..,"command":".."}],
+ "exited":[{"pid":..,"command":"..","exit_code":..,"cpu_seconds":..,
+ "runtime":..}],"exited_dropped":..}
+*/
+void Exporter::FormatNdjson(const Snapshot_t &snapshot) {
+  Append("{\"tick\":");
+  AppendInteger(snapshot.tick);
+  Append(",\"time_ns\":");
+  AppendInteger(snapshot.sampledAtNs);
+  Append(",\"jitter_ns\":");
+  AppendInteger(snapshot.jitterNs);
+  Append(",\"cpu\":{\"total\":");
+  AppendFloat(snapshot.cpu.total);
+  Append(",\"user\":");
+  AppendFloat(snapshot.cpu.user);
+  Append(",\"system\":");
+  AppendFloat(snapshot.cpu.system);
+  Append(",\"iowait\":");
+  AppendFloat(snapshot.cpu.iowait);
+  Append(",\"steal\":");
+  AppendFloat(snapshot.cpu.steal);
+  Append("},\"cores\":[");
+  for (size_t i = 0; i < snapshot.cores.size(); i++) {
+    if (i > 0) {
+      Append(",");
+    }
+    AppendFloat(snapshot.cores[i].total);
+  }
+  Append("],\"memory\":");
+  AppendFloat(snapshot.memory);
+  Append(",\"processes_total\":");
+  AppendInteger(snapshot.totalProcesses);
+  Append(",\"processes_running\":");
+  AppendInteger(snapshot.runningProcesses);
+  Append(",\"uptime\":");
+  AppendInteger(snapshot.uptime);
+  Append(",\"processes\":[");
+  for (size_t i = 0; i < snapshot.processes.size(); i++) {
+    const ProcessRow_t &row = snapshot.processes[i];
+    Append(i > 0 ? ",{\"pid\":" : "{\"pid\":");
+    AppendInteger(row.pid);
+    Append(",\"user\":");
+    AppendJsonString(row.user);
+    Append(",\"cpu\":");
+    AppendFloat(row.cpu);
+    Append(",\"ram_mb\":");
+    AppendSize(row.ramKb >= 0 ? row.ramKb / 1024 : -1, "null");
+    Append(",\"rss_kb\":");
+    AppendSize(row.ramKb, "null");
+    Append(",\"shared_kb\":");
+    AppendSize(row.sharedKb, "null");
+    Append(",\"text_kb\":");
+    AppendSize(row.textKb, "null");
+    Append(",\"pss_kb\":");
+    AppendSize(row.pssKb, "null");
+    Append(",\"uss_kb\":");
+    AppendSize(row.ussKb, "null");
+    Append(",\"memory_age\":");
+    if (row.memoryAge >= 0) {
+      AppendFloat(row.memoryAge);
+    } else {
+      Append("null");
+    }
+    Append(",\"read_bps\":");
+    AppendSize(row.readBps, "null");
+    Append(",\"write_bps\":");
+    AppendSize(row.writeBps, "null");
+    Append(",\"syscr_ps\":");
+    if (row.syscrPs >= 0) {
+      AppendFloat(row.syscrPs);
+    } else {
+      Append("null");
+    }
+    Append(",\"syscw_ps\":");
+    if (row.syscwPs >= 0) {
+      AppendFloat(row.syscwPs);
+    } else {
+      Append("null");
+    }
+    Append(",\"cancelled_write_bytes\":");
+    AppendSize(row.cancelledWriteBytes, "null");
+    Append(",\"uptime\":");
+    AppendInteger(row.uptime);
+    Append(",\"command\":");
+    AppendJsonString(row.command);
+    Append("}");
+  }
+  Append("],\"exited\":[");
+  for (size_t i = 0; i < snapshot.exited.size(); i++) {
+    const ExitRecord_t &exit = snapshot.exited[i];
+    Append(i > 0 ? ",{\"pid\":" : "{\"pid\":");
+    AppendInteger(exit.pid);
+    Append(",\"command\":");
+    AppendJsonString(std::string_view(exit.comm, strnlen(exit.comm, sizeof(exit.comm))));
+    Append(",\"exit_code\":");
+    AppendInteger(exit.exitCode);
+    Append(",\"cpu_seconds\":");
+    AppendFloat(exit.cpuSeconds);
+    Append(",\"runtime\":");
+    AppendFloat(exit.runtimeSeconds);
+    Append("}");
+  }
+  Append("],\"exited_dropped\":");
+  AppendInteger(snapshot.exitsDropped);
+  if (profile_) {
+    AppendNdjsonProfile(snapshot.profile);
+  }
+  Append("}\n");
+}
+
+/*
+,"profile":{"pids":{"last_ns":..,"p50_ns":..,"p99_ns":..,"max_ns":..},
+ ..,"render":{..},"rw_syscalls":{"last":..,"p50":..,"p99":..,"max":..}}
+*/
+void Exporter::AppendNdjsonProfile(const TickProfile_t &profile) {
+  auto appendPercentiles = [this](const Percentiles_t &value,
+                                  std::string_view unit) {
+    const std::string_view keys[]{"{\"last", ",\"p50", ",\"p99", ",\"max"};
+    const std::int64_t values[]{value.last, value.p50, value.p99, value.max};
+    for (int i = 0; i < 4; i++) {
+      Append(keys[i]);
+      Append(unit);
+      Append("\":");
+      AppendInteger(values[i]);
+    }
+    Append("}");
+  };
+
+  Append(",\"profile\":{");
+  for (size_t i = 0; i < kTickStages; i++) {
+    Append(i > 0 ? ",\"" : "\"");
+    Append(TickProfiler::StageName(static_cast<TickStage>(i)));
+    Append("\":");
+    appendPercentiles(profile.stages[i], "_ns");
+  }
+  Append(",\"rw_syscalls\":");
+  appendPercentiles(profile.syscalls, "");
+  Append("}");
+}
+
+/*
+tick,time_ns,cpu,memory,processes_total,processes_running,uptime,
+pid,user,proc_cpu,ram_mb,rss_kb,shared_kb,text_kb,pss_kb,uss_kb,memory_age,
+read_bps,write_bps,syscr_ps,syscw_ps,cancelled_write_bytes,proc_uptime,command
+then with the profile, for each stage and for rw_syscalls:
+<stage>_last_ns,<stage>_p50_ns,<stage>_p99_ns,<stage>_max_ns
+*/
+void Exporter::FormatCsv(const Snapshot_t &snapshot) {
+  if (!headerWritten_) {
+    Append("tick,time_ns,cpu,memory,processes_total,processes_running,"
+           "uptime,pid,user,proc_cpu,ram_mb,rss_kb,shared_kb,text_kb,pss_kb,"
+           "uss_kb,memory_age,read_bps,write_bps,syscr_ps,syscw_ps,"
+           "cancelled_write_bytes,proc_uptime,command");
+    if (profile_) {
+      for (size_t i = 0; i <= kTickStages; i++) {
+        std::string_view name =
+            i < kTickStages ? TickProfiler::StageName(static_cast<TickStage>(i))
+                            : "rw_syscalls";
+        for (std::string_view column : {"_last", "_p50", "_p99", "_max"}) {
+          Append(",");
+          Append(name);
+          Append(column);
+          Append(i < kTickStages ? "_ns" : "");
+        }
+      }
+    }
+    Append("\n");
+    headerWritten_ = true;
+  }
+
+  /* A tick without process rows still gets its system line */
+  if (snapshot.processes.empty()) {
+    AppendCsvSystem(snapshot);
+    Append(",,,,,,,,,,,,,,,,");
+    AppendCsvProfile(snapshot.profile);
+    Append("\n");
+    return;
+  }
+  for (const ProcessRow_t &row : snapshot.processes) {
+    AppendCsvSystem(snapshot);
+    AppendInteger(row.pid);
+    Append(",");
+    AppendCsvString(row.user);
+    Append(",");
+    AppendFloat(row.cpu);
+    Append(",");
+    AppendSize(row.ramKb >= 0 ? row.ramKb / 1024 : -1, "");
+    Append(",");
+    AppendSize(row.ramKb, "");
+    Append(",");
+    AppendSize(row.sharedKb, "");
+    Append(",");
+    AppendSize(row.textKb, "");
+    Append(",");
+    AppendSize(row.pssKb, "");
+    Append(",");
+    AppendSize(row.ussKb, "");
+    Append(",");
+    if (row.memoryAge >= 0) {
+      AppendFloat(row.memoryAge);
+    }
+    Append(",");
+    AppendSize(row.readBps, "");
+    Append(",");
+    AppendSize(row.writeBps, "");
+    Append(",");
+    if (row.syscrPs >= 0) {
+      AppendFloat(row.syscrPs);
+    }
+    Append(",");
+    if (row.syscwPs >= 0) {
+      AppendFloat(row.syscwPs);
+    }
+    Append(",");
+    AppendSize(row.cancelledWriteBytes, "");
+    Append(",");
+    AppendInteger(row.uptime);
+    Append(",");
+    AppendCsvString(row.command);
+    AppendCsvProfile(snapshot.profile);
+    Append("\n");
+  }
+}
+
+void Exporter::AppendCsvProfile(const TickProfile_t &profile) {
+  if (!profile_) {
+    return;
+  }
+  for (size_t i = 0; i <= kTickStages; i++) {
+    const Percentiles_t &value =
+        i < kTickStages ? profile.stages[i] : profile.syscalls;
+    for (std::int64_t number : {value.last, value.p50, value.p99, value.max}) {
+      Append(",");
+      AppendInteger(number);
+    }
+  }
+}
+
+void Exporter::AppendCsvSystem(const Snapshot_t &snapshot) {
+  AppendInteger(snapshot.tick);
+  Append(",");
+  AppendInteger(snapshot.sampledAtNs);
+  Append(",");
+  AppendFloat(snapshot.cpu.total);
+  Append(",");
+  AppendFloat(snapshot.memory);
+  Append(",");
+  AppendInteger(snapshot.totalProcesses);
+  Append(",");
+  AppendInteger(snapshot.runningProcesses);
+  Append(",");
+  AppendInteger(snapshot.uptime);
+  Append(",");
+}
+
+void Exporter::Append(std::string_view text) { buffer_.append(text); }
+
+void Exporter::AppendInteger(long long value) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer_.append(digits, result.ptr);
+}
+
+void Exporter::AppendFloat(float value) {
+  /* to_chars writes nan and inf, neither is a JSON number */
+  if (!std::isfinite(value)) {
+    Append(format_ == ExportFormat::kNdjson ? "null" : "");
+    return;
+  }
+  char digits[32];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value,
+                              std::chars_format::fixed, 4);
+  buffer_.append(digits, result.ptr);
+}
+
+void Exporter::AppendSize(long size, std::string_view missing) {
+  if (size >= 0) {
+    AppendInteger(size);
+  } else {
+    Append(missing);
+  }
+}
+
+void Exporter::AppendJsonString(std::string_view text) {
+  static const char kHex[] = "0123456789abcdef";
+  buffer_.push_back('"');
+  for (char c : text) {
+    unsigned char byte = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      buffer_.push_back('\\');
+      buffer_.push_back(c);
+    } else if (c == '\0') {
+      /* cmdline keeps the NUL separators of the arguments */
+      buffer_.push_back(' ');
+    } else if (byte < 0x20) {
+      char escaped[] = {'\\', 'u', '0', '0', kHex[byte >> 4], kHex[byte & 0xF]};
+      buffer_.append(escaped, sizeof(escaped));
+    } else {
+      buffer_.push_back(c);
+    }
+  }
+  buffer_.push_back('"');
+}
+
+void Exporter::AppendCsvString(std::string_view text) {
+  buffer_.push_back('"');
+  for (char c : text) {
+    if (c == '"') {
+      buffer_.push_back('"');
+      buffer_.push_back(c);
+    } else if (c == '\0' || c == '\n' || c == '\r') {
+      buffer_.push_back(' ');
+    } else {
+      buffer_.push_back(c);
+    }
+  }
+  buffer_.push_back('"');
+}
@@ -0,0 +1,249 @@
+#include "fixture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "linux_parser.h"
+
+using std::string;
+
+namespace {
+// comm values that break naive parsers
+const char *const kNastyComms[] = {
+    "(sd-pam)", "a b c",     ") (",          "x) S 1 2 3",
+    "((((",     "))))",      "kworker/0:1H", "tab\there",
+    "",         "fifteen-chars-x", "\xc3\xbc" "n" "\xc3\xaf" "c" "\xc3\xb8" "de",
+};
+const char *const kCommands[] = {
+    "bash",  "sshd",  "postgres", "python3", "java", "nginx",
+    "cc1plus", "node", "systemd", "make",   "rustc", "gcc",
+};
+const char kStates[] = {'S', 'S', 'S', 'S', 'R', 'D', 'I', 'Z'};
+
+bool makeDirectory(const string &path) {
+  return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool writeFile(const string &path, const string &content) {
+  FILE *file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written = fwrite(content.data(), 1, content.size(), file) ==
+                 content.size();
+  return fclose(file) == 0 && written;
+}
+
+string format(const char *pattern, ...) __attribute__((format(printf, 1, 2)));
+string format(const char *pattern, ...) {
+  char buffer[4096];
+  va_list args;
+  va_start(args, pattern);
+  int length = vsnprintf(buffer, sizeof(buffer), pattern, args);
+  va_end(args);
+  return string(buffer, length < 0 ? 0 : std::min<size_t>(length, sizeof(buffer) - 1));
+}
+
+bool writeSystemFiles(const string &proc, const Fixture::Options_t &options,
+                      std::mt19937 &random) {
+  std::uniform_int_distribution<long> jiffies(10000, 10000000);
+  string stat;
+  long total[10] = {};
+  string cores;
+  for (int core = 0; core < options.cores; core++) {
+    long values[10] = {jiffies(random), jiffies(random) / 10,
+                       jiffies(random) / 2, jiffies(random) * 4,
+                       jiffies(random) / 20, 0, jiffies(random) / 50,
+                       jiffies(random) / 100, 0, 0};
+    cores += format("cpu%d", core);
+    for (int i = 0; i < 10; i++) {
+      total[i] += values[i];
+      cores += format(" %ld", values[i]);
+    }
+    cores += '\n';
+  }
+  stat += "cpu ";
+  for (long value : total) {
+    stat += format(" %ld", value);
+  }
+  stat += '\n' + cores;
+  stat += format("intr %ld 0 9 0 0 0 0 0 0 0 1 0 0 156 0 0 0\n",
+                 jiffies(random) * 10);
+  stat += format("ctxt %ld\nbtime 1700000000\nprocesses %zu\n",
+                 jiffies(random) * 20, options.processes * 7);
+  stat += format("procs_running %zu\nprocs_blocked %zu\n",
+                 options.processes / 50 + 1, options.processes / 500);
+  stat += "softirq 1000 0 200 0 300 0 0 100 200 0 200\n";
+
+  string meminfo = "MemTotal:       32767236 kB\n"
+                   "MemFree:         8123456 kB\n"
+                   "MemAvailable:   20123456 kB\n"
+                   "Buffers:          512344 kB\n"
+                   "Cached:         11234568 kB\n"
+                   "SwapCached:            0 kB\n"
+                   "Active:         14567892 kB\n"
+                   "Inactive:        6789012 kB\n";
+
+  return writeFile(proc + "stat", stat) &&
+         writeFile(proc + "meminfo", meminfo) &&
+         writeFile(proc + "uptime", "864000.42 6543210.17\n") &&
+         writeFile(proc + "loadavg",
+                   format("1.52 1.31 1.07 %zu/%zu 4194000\n",
+                          options.processes / 50 + 1, options.processes)) &&
+         writeFile(proc + "version",
+                   "Linux version 6.1.0-fixture (builder@fixture) (gcc 12.2.0)"
+                   " #1 SMP PREEMPT_DYNAMIC\n");
+}
+
+bool writeProcess(const string &proc, int pid, const Fixture::Options_t &options,
+                  std::mt19937 &random) {
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::uniform_int_distribution<long> ticks(0, 500000);
+  std::uniform_int_distribution<long> pages(0, 200000);
+
+  bool kernelThread = percent(random) < 10;
+  bool nasty = percent(random) < 5;
+  char state = kStates[percent(random) % sizeof(kStates)];
+  string comm = nasty ? kNastyComms[percent(random) % std::size(kNastyComms)]
+                      : kCommands[percent(random) % std::size(kCommands)];
+  int uid = kernelThread ? 0 : 1000 + percent(random) % options.users;
+  long rss = state == 'Z' || kernelThread ? 0 : pages(random);
+  long vsize = rss * 4096 * 3;
+  int threads = 1 + percent(random) % 16;
+
+  string directory = proc + std::to_string(pid) + "/";
+  if (!makeDirectory(directory)) {
+    return false;
+  }
+
+  string stat = format(
+      "%d (%s) %c %d %d %d 0 -1 4194560 %ld 0 %ld 0 %ld %ld %ld %ld 20 0 %d 0 "
+      "%ld %ld %ld 18446744073709551615 1 1 0 0 0 0 0 4096 1088 0 0 0 17 %d "
+      "0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+      pid, comm.c_str(), state, kernelThread ? 2 : 1, pid, pid, ticks(random),
+      ticks(random) / 100, ticks(random), ticks(random) / 3,
+      ticks(random) / 10, ticks(random) / 10, threads, ticks(random) * 100,
+      vsize, rss, percent(random) % options.cores);
+
+  string status = format(
+      "Name:\t%s\nUmask:\t0022\nState:\t%c (sleeping)\nTgid:\t%d\nNgid:\t0\n"
+      "Pid:\t%d\nPPid:\t1\nTracerPid:\t0\nUid:\t%d\t%d\t%d\t%d\n"
+      "Gid:\t%d\t%d\t%d\t%d\nFDSize:\t64\nGroups:\t%d\nNStgid:\t%d\n"
+      "NSpid:\t%d\nNSpgid:\t%d\nNSsid:\t%d\n",
+      comm.c_str(), state, pid, pid, uid, uid, uid, uid, uid, uid, uid, uid,
+      uid, pid, pid, pid, pid);
+  if (!kernelThread && state != 'Z') {
+    status += format(
+        "VmPeak:\t%8ld kB\nVmSize:\t%8ld kB\nVmLck:\t       0 kB\n"
+        "VmPin:\t       0 kB\nVmHWM:\t%8ld kB\nVmRSS:\t%8ld kB\n"
+        "RssAnon:\t%8ld kB\nRssFile:\t%8ld kB\nRssShmem:\t       0 kB\n"
+        "VmData:\t%8ld kB\nVmStk:\t     132 kB\nVmExe:\t     900 kB\n"
+        "VmLib:\t    2000 kB\nVmPTE:\t      80 kB\nVmSwap:\t       0 kB\n",
+        vsize / 1024, vsize / 1024, rss * 4, rss * 4, rss * 3, rss, rss * 2);
+  }
+  status += format(
+      "Threads:\t%d\nSigQ:\t0/127368\nSigPnd:\t0000000000000000\n"
+      "ShdPnd:\t0000000000000000\nSigBlk:\t0000000000000000\n"
+      "SigIgn:\t0000000000001000\nSigCgt:\t0000000000000440\n"
+      "CapInh:\t0000000000000000\nCapPrm:\t0000000000000000\n"
+      "CapEff:\t0000000000000000\nCapBnd:\t000001ffffffffff\n"
+      "CapAmb:\t0000000000000000\nNoNewPrivs:\t0\nSeccomp:\t0\n"
+      "Speculation_Store_Bypass:\tthread vulnerable\n"
+      "Cpus_allowed:\tff\nCpus_allowed_list:\t0-7\n"
+      "Mems_allowed:\t00000001\nMems_allowed_list:\t0\n"
+      "voluntary_ctxt_switches:\t%ld\nnonvoluntary_ctxt_switches:\t%ld\n",
+      threads, ticks(random), ticks(random) / 10);
+
+  string statm = format("%ld %ld %ld %ld 0 %ld 0\n", vsize / 4096, rss,
+                        rss / 3, 225L, rss / 2);
+
+  /* Kernel threads have an empty cmdline, some commands are huge */
+  string cmdline;
+  if (!kernelThread) {
+    cmdline = "/usr/bin/" + comm;
+    cmdline += '\0';
+    int arguments = percent(random) < 2 ? 2000 : percent(random) % 8;
+    for (int i = 0; i < arguments; i++) {
+      cmdline += format("--option-%d=value", i);
+      cmdline += '\0';
+    }
+  }
+
+  /* Kernel threads do no accounted I/O */
+  long read = kernelThread ? 0 : ticks(random) * 4096;
+  string io = format("rchar: %ld\nwchar: %ld\nsyscr: %ld\nsyscw: %ld\n"
+                     "read_bytes: %ld\nwrite_bytes: %ld\n"
+                     "cancelled_write_bytes: %ld\n",
+                     read * 2, read / 2, read / 4096, read / 16384, read,
+                     read / 4, read / 64);
+
+  return writeFile(directory + "stat", stat) &&
+         writeFile(directory + "status", status) &&
+         writeFile(directory + "statm", statm) &&
+         writeFile(directory + "io", io) &&
+         writeFile(directory + "cmdline", cmdline);
+}
+
+bool writeEtc(const string &etc, const Fixture::Options_t &options) {
+  string passwd = "root:x:0:0:root:/root:/bin/bash\n"
+                  "daemon:x:1:1:daemon:/usr/sbin:/usr/sbin/nologin\n";
+  for (int user = 0; user < options.users; user++) {
+    passwd += format("user%d:x:%d:%d:Fixture User:/home/user%d:/bin/bash\n",
+                     user, 1000 + user, 1000 + user, user);
+  }
+  return writeFile(etc + "passwd", passwd) &&
+         writeFile(etc + "os-release",
+                   "PRETTY_NAME=\"Fixture Linux 1.0\"\nNAME=\"Fixture\"\n"
+                   "ID=fixture\n");
+}
+} // namespace
+
+/**
+ * @brief Writes a synthetic tree under root, root is created if needed
+ * and existing files are overwritten
+ *
+ * @param root : Directory receiving proc/ and etc/
+ * @param options : Size of the tree
+ * @return {bool} : false if a file could not be written
+ */
+bool Fixture::Generate(const string &root, const Options_t &options) {
+  string proc = root + "/proc/";
+  string etc = root + "/etc/";
+  if (!makeDirectory(root) || !makeDirectory(proc) || !makeDirectory(etc)) {
+    return false;
+  }
+
+  std::mt19937 random(options.seed);
+  if (!writeSystemFiles(proc, options, random) || !writeEtc(etc, options)) {
+    return false;
+  }
+
+  /* Pids are spread like on a long running host */
+  std::uniform_int_distribution<int> gap(1, 40);
+  int pid = 1;
+  for (size_t i = 0; i < options.processes; i++) {
+    if (!writeProcess(proc, pid, options, random)) {
+      return false;
+    }
+    pid += gap(random);
+  }
+  return true;
+}
+
+/**
+ * @brief Points LinuxParser at a tree written by Generate
+ *
+ * @param root : Directory given to Generate
+ */
+void Fixture::Use(const string &root) {
+  LinuxParser::SetProcDirectory(root + "/proc/");
+  LinuxParser::SetPasswordPath(root + "/etc/passwd");
+  LinuxParser::SetOSPath(root + "/etc/os-release");
+}
@@ -1,5 +1,5 @@
 #include "format.h"
-#include <iomanip> // for setw and setfill
+#include <charconv>
 #include <string>
 
 using std::string;
@@ -12,14 +12,32 @@ using std::string;
  * @return {string} : The formatted time string
  */
 string Format::ElapsedTime(long seconds) {
-  long hours = seconds / 3600;
-  long minutes = (seconds % 3600) / 60;
-  long secs = seconds % 60;
+  char buffer[kElapsedTimeSize];
+  return string(ElapsedTime(seconds, buffer));
+}
 
-  std::ostringstream stream;
-  stream << std::setw(2) << std::setfill('0') << hours << ":" << std::setw(2)
-         << std::setfill('0') << minutes << ":" << std::setw(2)
-         << std::setfill('0') << secs;
-
-  return stream.str();
-}
\ No newline at end of file
+/**
+ * @brief Formats a duration as HH:MM:SS into a caller buffer, without
+ * allocating
+ *
+ * @param seconds : The time in seconds
+ * @param buffer : Storage of the text
+ * @return {string_view} : The formatted time, points into buffer
+ */
+std::string_view Format::ElapsedTime(long seconds,
+                                     char (&buffer)[kElapsedTimeSize]) {
+  long const parts[]{seconds / 3600, (seconds % 3600) / 60, seconds % 60};
+  char *out = buffer;
+  char *const end = buffer + kElapsedTimeSize;
+  for (int i = 0; i < 3; i++) {
+    if (i > 0) {
+      *out++ = ':';
+    }
+    /* Two digits at least, zero padded */
+    if (parts[i] >= 0 && parts[i] < 10) {
+      *out++ = '0';
+    }
+    out = std::to_chars(out, end, parts[i]).ptr;
+  }
+  return std::string_view(buffer, out - buffer);
+}
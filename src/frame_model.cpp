@@ -0,0 +1,165 @@
+#include "frame_model.h"
+
+#include <algorithm>
+#include <charconv>
+
+/**
+ * @brief Construct a new FrameModel object
+ *
+ * @param window : Window drawn, nothing is drawn if null
+ * @param margin : Cells left untouched on each side (1 for a box)
+ */
+FrameModel::FrameModel(WINDOW *window, int margin)
+    : window_(window), margin_(margin) {
+  if (window_ == nullptr) {
+    return;
+  }
+  height_ = getmaxy(window_);
+  width_ = getmaxx(window_);
+  next_.resize(height_ * width_);
+  /* Nothing is on screen yet: every cell differs from the first frame */
+  drawn_.assign(height_ * width_, Cell_t{'\0', -1});
+  run_.resize(width_);
+}
+
+/**
+ * @brief Blanks the frame being composed
+ */
+void FrameModel::Clear() { std::fill(next_.begin(), next_.end(), Cell_t()); }
+
+/**
+ * @brief Writes text into the frame being composed, clipped to the
+ * window and to width cells
+ *
+ * @param y : Row in window coordinates
+ * @param x : Column in window coordinates
+ * @param text : Text, control characters are shown as spaces and
+ * each non-ASCII character (UTF-8 sequence) as one '?'
+ * @param pair : Color pair, 0 for the default colors
+ * @param width : Maximum number of cells, -1 for no limit
+ */
+void FrameModel::Put(int y, int x, std::string_view text, short pair,
+                     int width) {
+  if (y < margin_ || y >= height_ - margin_ || x < margin_) {
+    return;
+  }
+  int end = width_ - margin_;
+  if (width >= 0) {
+    end = std::min(end, x + width);
+  }
+  Cell_t *row = &next_[y * width_];
+  bool multibyte = false;
+  for (char c : text) {
+    unsigned char byte = static_cast<unsigned char>(c);
+    /* Continuation bytes share the cell of their lead byte, one cell per
+       character keeps the model in line with the terminal */
+    if ((byte & 0xC0) == 0x80 && multibyte) {
+      continue;
+    }
+    multibyte = byte >= 0xC0;
+    if (x >= end) {
+      break;
+    }
+    if (byte >= 0x80) {
+      row[x].ch = '?';
+    } else {
+      row[x].ch = byte < 0x20 || byte == 0x7f ? ' ' : c;
+    }
+    row[x].pair = pair;
+    x++;
+  }
+}
+
+/**
+ * @brief Writes an integer right aligned in width cells
+ *
+ * @param y : Row in window coordinates
+ * @param x : Column in window coordinates
+ * @param value : Number written
+ * @param width : Cells of the field, 0 to left align without padding
+ * @param pair : Color pair, 0 for the default colors
+ */
+void FrameModel::PutInteger(int y, int x, long long value, int width,
+                            short pair) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  int length = result.ptr - digits;
+  Put(y, x + std::max(0, width - length), std::string_view(digits, length),
+      pair);
+}
+
+/**
+ * @brief Writes a number with a fixed number of decimals right aligned
+ * in width cells
+ *
+ * @param y : Row in window coordinates
+ * @param x : Column in window coordinates
+ * @param value : Number written
+ * @param precision : Number of decimals
+ * @param width : Cells of the field, 0 to left align without padding
+ * @param pair : Color pair, 0 for the default colors
+ */
+void FrameModel::PutFixed(int y, int x, double value, int precision,
+                          int width, short pair) {
+  char digits[64];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value,
+                              std::chars_format::fixed, precision);
+  if (result.ec != std::errc()) {
+    return;
+  }
+  int length = result.ptr - digits;
+  Put(y, x + std::max(0, width - length), std::string_view(digits, length),
+      pair);
+}
+
+/**
+ * @brief Draws the cells that changed since the previous Flush and
+ * marks the window for the next doupdate()
+ *
+ * @return {bool} : false if nothing changed
+ */
+bool FrameModel::Flush() {
+  bool changed = false;
+  for (int y = margin_; y < height_ - margin_; y++) {
+    Cell_t *next = &next_[y * width_];
+    Cell_t *drawn = &drawn_[y * width_];
+
+    /* Changed span of the row */
+    int first = margin_;
+    int last = width_ - margin_ - 1;
+    while (first <= last && !(next[first] != drawn[first])) {
+      first++;
+    }
+    if (first > last) {
+      continue;
+    }
+    while (!(next[last] != drawn[last])) {
+      last--;
+    }
+
+    /* One call per run of cells sharing a color pair */
+    int x = first;
+    while (x <= last) {
+      short pair = next[x].pair;
+      int length = 0;
+      while (x + length <= last && next[x + length].pair == pair) {
+        run_[length] = next[x + length].ch;
+        length++;
+      }
+      if (pair != 0) {
+        wattron(window_, COLOR_PAIR(pair));
+      }
+      mvwaddnstr(window_, y, x, run_.data(), length);
+      if (pair != 0) {
+        wattroff(window_, COLOR_PAIR(pair));
+      }
+      x += length;
+    }
+    std::copy(next + first, next + last + 1, drawn + first);
+    changed = true;
+  }
+  if (changed) {
+    wnoutrefresh(window_);
+  }
+  return changed;
+}
@@ -1,10 +1,21 @@
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
 #include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <charconv>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <iterator>
 #include "linux_parser.h"
+#include "proc_files.h"
+#include "stat_parser.h"
+#include "user_cache.h"
 
 
 using std::stof;
@@ -14,17 +25,70 @@ using std::vector;
 
 #define RUN_PROCESS_KEY ("procs_running")
 #define UID_KEY  ("Uid:")
-#define KEY_VMRSS ("VmRSS:")
+
+static string procDirectory{"/proc/"};
+static string osPath{"/etc/os-release"};
+static string passwordPath{"/etc/passwd"};
+// Bound on the N of a "cpuN" line, above any NR_CPUS
+static constexpr size_t kMaxCores = 1 << 16;
 
 /**
- * @brief This function checks if a string is a number
- * This includes also floating point numbers
- * 
- * @param str : String to check
- * @return {true} : String is a number 
- * @return {false} : String is not a number 
+ * @brief Parses the jiffies following the key of a "cpu" line of /proc/stat.
+ * Older kernels print less than ten columns, missing ones are left to 0.
+ *
+ * @param first : Start of the values
+ * @param last : End of the line
+ * @param times : Structure to fill
+ */
+static void parseCpuTimes(const char *first, const char *last,
+                          LinuxParser::CpuTimes_t &times);
+
+/**
+ * @brief Returns the directory holding the proc files, ends with '/'
+ *
+ * @return {const std::string&} : The proc directory
+ */
+const string &LinuxParser::ProcDirectory() { return procDirectory; }
+
+/**
+ * @brief Returns the path of the os-release file
+ *
+ * @return {const std::string&} : The os-release path
+ */
+const string &LinuxParser::OSPath() { return osPath; }
+
+/**
+ * @brief Returns the path of the passwd file
+ *
+ * @return {const std::string&} : The passwd path
+ */
+const string &LinuxParser::PasswordPath() { return passwordPath; }
+
+/**
+ * @brief Changes the directory holding the proc files
+ *
+ * @param directory : New directory, a trailing '/' is added if missing
+ */
+void LinuxParser::SetProcDirectory(const string &directory) {
+  procDirectory = directory;
+  if (procDirectory.empty() || procDirectory.back() != '/') {
+    procDirectory += '/';
+  }
+}
+
+/**
+ * @brief Changes the path of the os-release file
+ *
+ * @param path : New path
  */
-static bool isNumber(const std::string& str);
+void LinuxParser::SetOSPath(const string &path) { osPath = path; }
+
+/**
+ * @brief Changes the path of the passwd file
+ *
+ * @param path : New path
+ */
+void LinuxParser::SetPasswordPath(const string &path) { passwordPath = path; }
 
 /**
  * @brief Reads the operating system name from the /etc/os-release file
@@ -38,7 +102,7 @@ string LinuxParser::OperatingSystem() {
   string line;
   string key;
   string value;
-  std::ifstream filestream(kOSPath);
+  std::ifstream filestream(OSPath());
   if (filestream.is_open()) {
     while (std::getline(filestream, line)) {
       std::replace(line.begin(), line.end(), ' ', '_');
@@ -66,7 +130,7 @@ string LinuxParser::OperatingSystem() {
 string LinuxParser::Kernel() {
   string os, version, kernel;
   string line;
-  std::ifstream stream(kProcDirectory + kVersionFilename);
+  std::ifstream stream(ProcDirectory() + kVersionFilename);
   if (stream.is_open()) {
     std::getline(stream, line);
     std::istringstream linestream(line);
@@ -75,24 +139,78 @@ string LinuxParser::Kernel() {
   return kernel;
 }
 
-// BONUS: Update this to use std::filesystem
+/**
+ * @brief Lists the pids of the proc directory
+ *
+ * @return {std::vector<int>} : Pids in ascending order
+ */
 vector<int> LinuxParser::Pids() {
   vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
-  struct dirent* file;
-  while ((file = readdir(directory)) != nullptr) {
-    // Is this a directory?
-    if (file->d_type == DT_DIR) {
-      // Is every character of the name a digit?
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
-        pids.push_back(pid);
+  Pids(pids);
+  return pids;
+}
+
+/**
+ * @brief Lists the pids of the proc directory into a caller vector
+ * Entries are read in batches with getdents64 into a buffer kept by the
+ * calling thread and the names are parsed in place, nothing is
+ * allocated once the vectors reached their size.
+ *
+ * @param pids : Receives the pids in ascending order, its capacity is
+ * kept. With a delta it must hold the previous scan on input.
+ * @param delta : If not null, receives the pids added and removed since
+ * the previous scan held by pids
+ * @return {bool} : false if the directory could not be read entirely
+ */
+bool LinuxParser::Pids(vector<int> &pids, PidDelta_t *delta) {
+  thread_local vector<char> buffer(kDirentBufferSize);
+  thread_local vector<int> scanned;
+  vector<int> &out = delta != nullptr ? scanned : pids;
+  out.clear();
+
+  int fd = open(ProcDirectory().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  long size;
+  while ((size = syscall(SYS_getdents64, fd, buffer.data(), buffer.size())) >
+         0) {
+    for (long offset = 0; offset < size;) {
+      const struct dirent64 *entry =
+          reinterpret_cast<const struct dirent64 *>(buffer.data() + offset);
+      offset += entry->d_reclen;
+      if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
+        continue;
+      }
+      /* Every character of the name must be a digit */
+      const char *name = entry->d_name;
+      int pid = 0;
+      for (; *name >= '0' && *name <= '9'; name++) {
+        pid = pid * 10 + (*name - '0');
+      }
+      if (*name == '\0' && name != entry->d_name) {
+        out.push_back(pid);
       }
     }
   }
-  closedir(directory);
-  return pids;
+  close(fd);
+
+  /* proc lists pids in order, other trees may not */
+  if (!std::is_sorted(out.begin(), out.end())) {
+    std::sort(out.begin(), out.end());
+  }
+
+  if (delta != nullptr) {
+    /* Sorted merge of the previous and the new scan */
+    delta->added.clear();
+    delta->removed.clear();
+    std::set_difference(scanned.begin(), scanned.end(), pids.begin(),
+                        pids.end(), std::back_inserter(delta->added));
+    std::set_difference(pids.begin(), pids.end(), scanned.begin(),
+                        scanned.end(), std::back_inserter(delta->removed));
+    pids.swap(scanned);
+  }
+  return size == 0;
 }
 
 /**
@@ -115,54 +233,43 @@ vector<int> LinuxParser::Pids() {
  */
 float LinuxParser::MemoryUtilization(MemoryUtilData_t &memoryUtilData) 
 { 
-  string key;
-  string value;
-  string line;
-  vector<int> memValues;
-  /* Create an input file stream from file meminfo containing memory util data*/
-  std::ifstream memInfoStream(kProcDirectory + kMeminfoFilename);
+  thread_local string buffer;
+  std::string_view text;
+  if (!ProcFiles::Instance().Read(ProcFiles::kMeminfo_, buffer, text))
+  {
+    return 0.0;
+  }
 
-  /* Check if the stream is opened successfully */
-  if (memInfoStream.is_open())
+  /* Look up MemTotal, MemFree, MemAvailable and Buffers by key */
+  struct Field_t { std::string_view key; float *value; };
+  const Field_t fields[] = {{"MemTotal:", &memoryUtilData.MEM_TOTAL},
+                            {"MemFree:", &memoryUtilData.MEM_FREE},
+                            {"MemAvailable:", &memoryUtilData.MEM_AVAILABLE},
+                            {"Buffers:", &memoryUtilData.MEM_BUFFERS}};
+  int found = 0;
+  const char *first = text.data();
+  const char *const end = first + text.size();
+  while (first < end && found < 4)
   {
-    /* iterate threw the 4 first lines for MemTotal, MemFree, MemAvailable and Buffers*/
-    for (int l_idx = 0; l_idx < 4; l_idx++)
+    const char *last = std::find(first, end, '\n');
+    const char *keyEnd = std::find(first, last, ' ');
+    std::string_view key(first, keyEnd - first);
+    for (const Field_t &field : fields)
     {
-      /* Read line and store it in line variable */
-      if (std::getline(memInfoStream, line))
+      long value;
+      if (key == field.key && ParseNumber(keyEnd, last, value))
       {
-        /* Create input string stream from the line we just read */
-        std::istringstream linestream(line);
-        /* Extract key and value */
-        linestream >> key >> value;
-        /* Check if the value is a number */
-        if (isNumber(value))
-        {
-          /* Push it in the memValues vector */
-          memValues.push_back(stoi(value));
-        }
-        else
-        {
-           //error
-        }
-      }
-      else
-      {
-        //error
+        *field.value = value;
+        found++;
       }
     }
+    first = last + 1;
   }
-  else
+
+  if (memoryUtilData.MEM_TOTAL <= 0)
   {
-    //error
+    return 0.0;
   }
-
-  /* Parse extracted values in a structure */
-  memoryUtilData.MEM_TOTAL = memValues[0];
-  memoryUtilData.MEM_FREE = memValues[1];
-  memoryUtilData.MEM_AVAILABLE = memValues[2];
-  memoryUtilData.MEM_BUFFERS = memValues[3];
-
   /* Return memory ulitzation in percent */
   return float((memoryUtilData.MEM_TOTAL - memoryUtilData.MEM_FREE) / memoryUtilData.MEM_TOTAL); 
 }
@@ -177,46 +284,15 @@ float LinuxParser::MemoryUtilization(MemoryUtilData_t &memoryUtilData)
  */
 long int LinuxParser::UpTime() 
 { 
-  string line;
-  string uptimeValue;
+  thread_local string buffer;
+  std::string_view text;
   long int returnValue = 0;
-  /* Create input file stream from /proc/uptime*/
-  std::ifstream streamUpTime(kProcDirectory + kUptimeFilename);
-
-  /* Check if it is open */
-  if (streamUpTime.is_open())
-  {
-    /* Only one line in this file so we read it and check if it is read correctly */
-    if (std::getline(streamUpTime, line))
-    {
-      /* Create string stream from this line */
-      std::stringstream lineStream(line);
-
-      /* Get the Uptime value */
-      lineStream >> uptimeValue;
-
-      /* Check if it is a number */
-      if (isNumber(uptimeValue))
-      {
-        /* Convert to long */
-        returnValue = stol(uptimeValue);
-      }
-      else
-      {
-        //error
-      }
-    }
-    else
-    {
-      //error
-    }
-    
-  }
-  else
+  /* Only the integer part of the first number is kept */
+  if (ProcFiles::Instance().Read(ProcFiles::kUptime_, buffer, text))
   {
-    //error
+    const char *first = text.data();
+    ParseNumber(first, first + text.size(), returnValue);
   }
-  
   return returnValue; 
 }
 
@@ -226,7 +302,9 @@ long int LinuxParser::UpTime()
  * @return {long} : The total CPU utilization 
  */
 long LinuxParser::Jiffies() {
-  return LinuxParser::ActiveJiffies() + LinuxParser::IdleJiffies();
+  StatSnapshot_t snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.cpu.Total();
 }
 
 /**
@@ -235,22 +313,9 @@ long LinuxParser::Jiffies() {
  * @return {long} : The number of active jiffies for the system 
  */
 long LinuxParser::ActiveJiffies() {
-  std::vector<std::string> cpuUtilization = LinuxParser::CpuUtilization();
-  long int activeJiffies = 0;
-  
-  if (cpuUtilization.size() > kGuestNice_)
-  {
-    activeJiffies = std::stol(cpuUtilization[kUser_]) 
-                    + std::stol(cpuUtilization[kNice_]) 
-                    + std::stol(cpuUtilization[kSystem_]) 
-                    + std::stol(cpuUtilization[kSoftIRQ_]) 
-                    + std::stol(cpuUtilization[kSteal_]) 
-                    + std::stol(cpuUtilization[kGuest_]) 
-                    + std::stol(cpuUtilization[kGuestNice_]);
-  }
-  
-
-  return activeJiffies;
+  StatSnapshot_t snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.cpu.Active();
 }
 
 /**
@@ -259,55 +324,75 @@ long LinuxParser::ActiveJiffies() {
  * @return {long} : The number of idle jiffies for the system 
  */
 long LinuxParser::IdleJiffies() {
-  std::vector<std::string> cpuUtilization = LinuxParser::CpuUtilization();
-  long int idleJiffies = 0;
-
-  if (cpuUtilization.size() > kIOwait_)
-  {
-    idleJiffies = std::stol(cpuUtilization[kIdle_]) + std::stol(cpuUtilization[kIOwait_]);
-  }
-  {
-    /* code */
-  }
-
-  return idleJiffies;
+  StatSnapshot_t snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.cpu.Idle();
 }
 
 /**
- * @brief Reads /proc/stat file and extracts the CPU utilization
- * 
- * @return {std::vector<std::string>} : Vector containing the CPU utilization data
+ * @brief Reads /proc/stat once and fills every field of the snapshot.
+ * The cores vector is resized in place so its capacity is reused
+ * from one tick to the next.
+ *
+ * @param snapshot : Snapshot to fill
+ * @return {bool} : true if the file could be read
  */
-vector<string> LinuxParser::CpuUtilization() 
-{
-  string line;
-  vector<string> values;
-  std::ifstream stream(kProcDirectory + kStatFilename);
-  
-  if (stream.is_open()) 
-  {
-    if (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      std::istream_iterator<string> begin(linestream), end;
-      // Skip "cpu" by advancing iterator
-      begin = std::next(begin);
-      values = vector<string>(begin, end);
-    } 
-    else 
-    {
-      //error
+bool LinuxParser::ReadStatSnapshot(StatSnapshot_t &snapshot) {
+  thread_local string buffer;
+  std::string_view text;
+  if (!ProcFiles::Instance().Read(ProcFiles::kStat_, buffer, text)) {
+    return false;
+  }
+
+  /* Cores seen so far, an offline CPU has no line and leaves a gap */
+  size_t nbCores = 0;
+  const char *const end = text.data() + text.size();
+  for (const char *first = text.data(), *last; first < end;
+       first = last + 1) {
+    last = std::find(first, end, '\n');
+    const char *keyEnd = std::find(first, last, ' ');
+    std::string_view key(first, keyEnd - first);
+
+    if (key.compare(0, 3, "cpu") == 0) {
+      CpuTimes_t *times = &snapshot.cpu;
+      if (key.size() > 3) {
+        /* Indexed by the N of "cpuN", not by the line, so a core keeps
+           its slot when a CPU before it is offline */
+        const char *digits = key.data() + 3;
+        size_t core;
+        if (!ParseNumber(digits, keyEnd, core) || digits != keyEnd ||
+            core >= kMaxCores) {
+          continue;
+        }
+        if (snapshot.cores.size() <= core) {
+          snapshot.cores.resize(core + 1);
+        }
+        /* Offline CPUs read as zero jiffies */
+        for (size_t gap = nbCores; gap < core; gap++) {
+          snapshot.cores[gap] = CpuTimes_t();
+        }
+        nbCores = std::max(nbCores, core + 1);
+        times = &snapshot.cores[core];
+      }
+      parseCpuTimes(keyEnd, last, *times);
+    } else if (key == "ctxt") {
+      ParseNumber(keyEnd, last, snapshot.ctxt);
+    } else if (key == "intr") {
+      /* Only the total, the per-irq counters are not used */
+      ParseNumber(keyEnd, last, snapshot.intr);
+    } else if (key == "processes") {
+      ParseNumber(keyEnd, last, snapshot.processes);
+    } else if (key == RUN_PROCESS_KEY) {
+      ParseNumber(keyEnd, last, snapshot.procsRunning);
+    } else if (key == "procs_blocked") {
+      ParseNumber(keyEnd, last, snapshot.procsBlocked);
     }
-  } 
-  else 
-  {
-    //error
   }
+  snapshot.cores.resize(nbCores);
 
-  return values;
+  return true;
 }
 
-  
-
 /**
  * @brief Reads /proc/stat file and extracts the total number of processes  
  * which is the value to the key "processes".
@@ -316,46 +401,9 @@ vector<string> LinuxParser::CpuUtilization()
  */
 int LinuxParser::TotalProcesses() 
 { 
-  string key = "";
-  string value = "0";
-  string line;
-  std::ifstream statStream(kProcDirectory + kStatFilename);
-  int totProcessNb = 0;
-
-  /* Check if input file stream is open */
-  if (statStream.is_open())
-  {
-    /* As long as the key is different from "processes"*/
-    while (key != "processes")
-    {
-      /* Read line and check if it is read correctly */
-      if (std::getline(statStream, line))
-      {
-        /* Create string stream from line */
-        std::istringstream lineStream(line);
-
-        lineStream >> key >> value;
-      }
-      else
-      {
-        //error
-      }
-    }
-    
-  }
-  else
-  {
-    //error
-  }
-  
-  /* If value found is a number */
-  if (isNumber(value))
-  {
-    /* Convert to int and store it in return var */
-    totProcessNb = stoi(value);
-  }
-  
-  return totProcessNb; 
+  StatSnapshot_t snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.processes;
 }
 
 /**
@@ -366,51 +414,9 @@ int LinuxParser::TotalProcesses()
  */
 int LinuxParser::RunningProcesses() 
 { 
-  string key = "";
-  string value = "0";
-  string line;
-  int nbOfRunningProcesses = 0;
-  /* Open a file input stream from file /proc/stat */
-  std::ifstream statStream(kProcDirectory + kStatFilename);
-
-  /* Check if the input stream is opened correctly */
-  if (statStream.is_open())
-  {
-    /* loop through the file until the key procs_running is found */
-    while (key != RUN_PROCESS_KEY)
-    {
-      /* Read the line */
-      if (std::getline(statStream, line))
-      {
-        /* Create a string stream from this line */
-        std::istringstream lineStream(line);
-        /* Get key and Value */
-        lineStream >> key >> value;
-
-      }
-      else
-      {
-        //error
-      }
-    }
-    
-    /* Check if the value found is actually a number */
-    if (isNumber(value))
-    {
-      nbOfRunningProcesses = stoi(value);
-    }
-    else
-    {
-      //error
-    }
-  }
-  else
-  {
-    //error
-  }
-  
-  /* Convert and return the value */
-  return nbOfRunningProcesses; 
+  StatSnapshot_t snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.procsRunning;
 }
 
 /**
@@ -425,7 +431,7 @@ string LinuxParser::Command(string pid)
 { 
   string line;
   string command = "No command found";
-  std::ifstream cmdlineStream(kProcDirectory + pid + kCmdlineFilename);
+  std::ifstream cmdlineStream(ProcDirectory() + pid + kCmdlineFilename);
   
   if (cmdlineStream.is_open())
   {
@@ -440,63 +446,155 @@ string LinuxParser::Command(string pid)
 }
 
 /**
- * @brief Retrieves memory size of a process from /proc/pid/status file
- * We take the size indicated by the key "VmRSS:" and convert it to Mb
- * instead of VmSize which is the total virtual memory size of the process
- * because it includes shared memory and memory that is swapped out
- * 
+ * @brief Reads /proc/pid/statm, a single line of seven page counts,
+ * with one read() into a stack buffer and without any heap allocation
+ *
  * @param pid : Process ID
- * @return {string} : Memory size of the process in Mb 
+ * @param statm : Structure to fill, in kB
+ * @return {bool} : false if the process is gone or the file is truncated
  */
-string LinuxParser::Ram(string pid) {
+bool LinuxParser::ReadStatm(int pid, Statm_t &statm)
+{
+  static const long pageKb = sysconf(_SC_PAGESIZE) / 1024;
+  char buffer[128];
+  size_t size = 0;
+  if (!ReadPidFile(pid, kStatmFilename, buffer, sizeof(buffer), size)) {
+    return false;
+  }
 
-  string line;
-  string key = " ";
-  string value = "0";
-  bool vmSizeFound = false;
-  string retVal = "N/A";
-  /* Create input file stream from status file */
-  std::ifstream streamStatus(kProcDirectory + pid + kStatusFilename);
-
-  /* check if it is open */
-  if (streamStatus.is_open())
+  /* size resident shared text lib data dt, lib and dt are always 0 */
+  const char *first = buffer;
+  const char *last = buffer + size;
+  long lib = 0;
+  if (!ParseNumber(first, last, statm.size) ||
+      !ParseNumber(first, last, statm.resident) ||
+      !ParseNumber(first, last, statm.shared) ||
+      !ParseNumber(first, last, statm.text) ||
+      !ParseNumber(first, last, lib) ||
+      !ParseNumber(first, last, statm.data)) {
+    return false;
+  }
+  statm.size *= pageKb;
+  statm.resident *= pageKb;
+  statm.shared *= pageKb;
+  statm.text *= pageKb;
+  statm.data *= pageKb;
+  return true;
+}
+
+/**
+ * @brief Retrieves the resident memory of a process from /proc/pid/statm
+ * The resident set size is used instead of VmSize, the total virtual
+ * memory size of the process, because it includes shared memory and
+ * memory that is swapped out
+ *
+ * @param pid : Process ID
+ * @return {long} : Resident memory in kB, -1 if the process has no
+ * address space or is gone
+ */
+long LinuxParser::Ram(int pid) {
+  Statm_t statm;
+  if (!ReadStatm(pid, statm) || statm.size == 0) {
+    return -1;
+  }
+  return statm.resident;
+}
+
+/**
+ * @brief Reads /proc/pid/smaps_rollup with one read() into a stack
+ * buffer. The kernel walks every mapping of the process to produce it,
+ * so it costs far more than statm (see MemorySampler).
+ *
+ * @param pid : Process ID
+ * @param rollup : Structure to fill
+ * @return {bool} : false if the process is gone, has no address space or
+ * the file cannot be read (other users' processes need ptrace access)
+ */
+bool LinuxParser::ReadSmapsRollup(int pid, SmapsRollup_t &rollup)
+{
+  struct Field_t {
+    std::string_view key;
+    long *value;
+  };
+  const Field_t fields[]{{"Rss:", &rollup.rss},
+                         {"Pss:", &rollup.pss},
+                         {"Private_Clean:", &rollup.privateClean},
+                         {"Private_Dirty:", &rollup.privateDirty},
+                         {"SwapPss:", &rollup.swapPss}};
+  char buffer[4096];
+  size_t size = 0;
+  if (!ReadPidFile(pid, kSmapsRollupFilename, buffer, sizeof(buffer), size)) {
+    return false;
+  }
+
+  /* The first line is the address range of the rollup, then "Key: N kB" */
+  size_t found = 0;
+  const char *first = buffer;
+  const char *end = buffer + size;
+  while (first < end && found < std::size(fields))
   {
-    /* Start reading file line by line */
-    while (std::getline(streamStatus, line))
+    const char *last = std::find(first, end, '\n');
+    const char *keyEnd = std::find(first, last, ' ');
+    std::string_view key(first, keyEnd - first);
+    for (const Field_t &field : fields)
     {
-      /* Create line stream */
-      std::istringstream lineStream(line);
-      /* Read key and value in that line */
-      lineStream >> key >> value;
-
-      /* If the key is Vmsize:*/
-      if (key == KEY_VMRSS)
+      if (key == field.key && ParseNumber(keyEnd, last, *field.value))
       {
-        /* Set found flag to true */
-        vmSizeFound = true;
-        /* break while loop */
-        break;
+        found++;
       }
     }
-    
-  }
-  else
-  {
-    /*error opening file*/
+    first = last + 1;
   }
+  return found == std::size(fields);
+}
 
-  /* Check if vmsize is found */
-  if (vmSizeFound)
-  {
-    /* Convert value to Mb */
-    retVal = to_string(stol(value) / 1024);
+/**
+ * @brief Reads /proc/pid/io with one read() into a stack buffer and
+ * without any heap allocation
+ *
+ * @param pid : Process ID
+ * @param io : Structure to fill
+ * @return {bool} : false if the file cannot be read, errno is EACCES
+ * when the monitor may not trace the process (another user's process
+ * when not root)
+ */
+bool LinuxParser::ReadProcIo(int pid, ProcIo_t &io)
+{
+  struct Field_t {
+    std::string_view key;
+    unsigned long long *value;
+  };
+  const Field_t fields[]{{"rchar:", &io.rchar},
+                         {"wchar:", &io.wchar},
+                         {"syscr:", &io.syscr},
+                         {"syscw:", &io.syscw},
+                         {"read_bytes:", &io.readBytes},
+                         {"write_bytes:", &io.writeBytes},
+                         {"cancelled_write_bytes:", &io.cancelledWriteBytes}};
+  char buffer[512];
+  size_t size = 0;
+  if (!ReadPidFile(pid, kIoFilename, buffer, sizeof(buffer), size)) {
+    return false;
   }
-  else /* Zombie process*/
+
+  size_t found = 0;
+  const char *first = buffer;
+  const char *end = buffer + size;
+  while (first < end)
   {
-    retVal = "N/A";
+    const char *last = std::find(first, end, '\n');
+    const char *keyEnd = std::find(first, last, ' ');
+    std::string_view key(first, keyEnd - first);
+    for (const Field_t &field : fields)
+    {
+      if (key == field.key && ParseNumber(keyEnd, last, *field.value))
+      {
+        found++;
+      }
+    }
+    first = last + 1;
   }
-  
-  return retVal;
+  return found == std::size(fields);
 }
 
 /**
@@ -512,22 +610,20 @@ string LinuxParser::Uid(string pid)
     string line;
     /* Find the UID associated with the process */
     /* Create input file stream from /proc/pid/status */
-    std::ifstream statuStream(LinuxParser::kProcDirectory + pid + LinuxParser::kStatusFilename);
+    std::ifstream statuStream(ProcDirectory() + pid + LinuxParser::kStatusFilename);
 
     /* Check if the file stream is open */
     if (statuStream.is_open())
     {
         /* Read lines until key Uid is found */
-        while (key != UID_KEY)
+        while (std::getline(statuStream, line))
         {
-          /* Check if line is read correctly*/
-          if(std::getline(statuStream, line))
-          {
-              statuStream >> key >> uid;
-          }
-          else
+          std::istringstream lineStream(line);
+          lineStream >> key;
+          if (key == UID_KEY)
           {
-            //error
+            lineStream >> uid;
+            break;
           }
         }
     }
@@ -540,173 +636,73 @@ string LinuxParser::Uid(string pid)
 }
 
 /**
- * @brief Reads /etc/passwd file and extracts the user name associated with the UID
- *  the function loops through the file line by line formatting the line by replacing
- * ':' with ' ' and then extracts the user name associated with the UID
- * if the UID is not found the function returns "UNKNOWN"
+ * @brief Returns the user name associated with the UID
+ * The name is served by the process-wide UserCache which loads /etc/passwd
+ * once and falls back to NSS for uids missing from the file.
+ * if the UID is not a number the function returns "UNKNOWN"
  * @param uid 
  * @return string 
  */
 string LinuxParser::User(string uid) 
 { 
-  string userId = "";
-  string returnValue = "UNKNOWN";
-  std::ifstream passwdStream(kPasswordPath);
-  string value = " ";
-  string x;
-  string line;
-
-  if (passwdStream.is_open())
+  uid_t value = 0;
+  const char *first = uid.data();
+  const char *last = first + uid.size();
+  if (!ParseNumber(first, last, value))
   {
-    while (value != uid)
-    {
-      if (std::getline(passwdStream, line))
-      {
-        std::replace(line.begin(), line.end(), ':', ' ');
-        std::istringstream lineStream(line);
-        lineStream >> userId >> x >> value;
-      }
-      else
-      {
-        //error
-      }
-    }
-
-    returnValue = userId;
+    return "UNKNOWN";
   }
-  else
-  {
-    //error
-  }
-
-  return returnValue; 
-}
-
-/**
- * @brief Reads the /proc/pid/stat file and extracts all the data
- * then returns the starttime at index 22 which is the uptime in seconds
- * of this process.
- * 
- * @param pid : Process ID.
- * @return {long} : The uptime time of the process in seconds.
- */
-long LinuxParser::UpTime(string pid) 
-{ 
-    string line;
-    string value;
-    vector<string> valuesFromFile;
-    /* Create file iput stream from file /proc/pid/stat */
-    std::ifstream statStream(kProcDirectory + pid + kStatFilename);
-
-    /* Check file stream is open */
-    if (statStream.is_open())
-    {
-      /* Read line and check if it is read successfully*/
-      if (std::getline(statStream, line))
-      {
-        /* Create string stram from line */
-        std::istringstream lineStream(line);
-        
-        /* Read values in the line */
-        while (lineStream >> value)
-        {
-          /* Store each value in a vector */
-          valuesFromFile.push_back(value);
-        }
-        
-      }
-      else
-      {
-        //error
-      }
-    }
-    else
-    {
-      //error
-    }
 
-  return valuesFromFile[21] != "" ? std::stol(valuesFromFile[21]) : 0; 
+  return UserCache::Instance().Lookup(value);
 }
 
 /**
- * @brief Reads /proc/pid/stat file and extract necesary data
- * for process cpu utilization in a map :
- * idx 14 utime - CPU time spent in user code, measured in clock ticks
- * idx 15 stime - CPU time spent in kernel code, measured in clock ticks
- * idx 16 cutime - Waited-for children's CPU time spent in user code (in clock ticks)
- * idx 17 cstime - Waited-for children's CPU time spent in kernel code (in clock ticks)
- * idx 22 starttime - Time when the process started, measured in clock ticks
- * 
+ * @brief Reads a file of a process directory with a single read() into
+ * a caller buffer, for the small records parsed without allocation
+ * (see StatParser)
+ *
  * @param pid : Process ID
- * @return {std::map<std::string, long>} : Map containing the data
+ * @param filename : File name in the process directory, e.g. kStatFilename
+ * @param buffer : Receives the content
+ * @param capacity : Size of buffer
+ * @param size : Receives the number of bytes read
+ * @return {bool} : false if the process is gone or the file is empty,
+ * errno then tells why
  */
-std::map<std::string, long> LinuxParser::processUtilData(string pid)
+bool LinuxParser::ReadPidFile(int pid, const string &filename, char *buffer,
+                              size_t capacity, size_t &size)
 {
-    std::map<std::string, long> processUtilData;
-    string line;
-    string value;
-    vector<string> valuesFromFile;
-    /* Create file iput stream from file /proc/pid/stat */
-    std::ifstream statStream(kProcDirectory + pid + kStatFilename);
+  char path[256];
 
-    /* Check file stream is open */
-    if (statStream.is_open())
-    {
-      /* Read line and check if it is read successfully*/
-      if (std::getline(statStream, line))
-      {
-        /* Create string stram from line */
-        std::istringstream lineStream(line);
-        
-        /* Read values in the line */
-        while (lineStream >> value)
-        {
-          /* Store each value in a vector */
-          valuesFromFile.push_back(value);
-        }
-        
-      }
-      else
-      {
-        //error
-      }
-    }
-    else
-    {
-      //error
-    }
-
-    /* Check if the vector size is coherent */
-    if (valuesFromFile.size() > 22) {
-        processUtilData[KEY_UTIME] = std::stol(valuesFromFile[UTIME_IDX]);
-        processUtilData[KEY_STIME] = std::stol(valuesFromFile[STIME_IDX]);
-        processUtilData[KEY_CUTIME] = std::stol(valuesFromFile[CUTIME_IDX]);
-        processUtilData[KEY_CSTIME] = std::stol(valuesFromFile[CSTIME_IDX]);
-        processUtilData[KEY_STARTTIME] = std::stol(valuesFromFile[STARTTIME_IDX]);
-    }
-
-    return processUtilData;
+  int length = snprintf(path, sizeof(path), "%s%d%s", ProcDirectory().c_str(),
+                        pid, filename.c_str());
+  if (length < 0 || size_t(length) >= sizeof(path)) {
+    return false;
+  }
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  ssize_t result = read(fd, buffer, capacity);
+  /* Callers may look at the errno of a failed read (EACCES) */
+  int const error = errno;
+  close(fd);
+  if (result <= 0) {
+    errno = error;
+    return false;
+  }
+  size = size_t(result);
+  return true;
 }
 
-/**
- * @brief This function checks if a string is a number
- * This includes also floating point numbers
- * 
- * @param str : String to check
- * @return true 
- * @return false 
- */
-static bool isNumber(const std::string& str) {
-    bool decimalPointSeen = false;
-
-    for (char c : str) {
-        if (c == '.') {
-            if (decimalPointSeen) return false; // More than one decimal point
-            decimalPointSeen = true;
-        } else if (!std::isdigit(c)) {
-            return false;
-        }
+static void parseCpuTimes(const char *first, const char *last,
+                          LinuxParser::CpuTimes_t &times) {
+  for (long &value : times.values) {
+    value = 0;
+  }
+  for (long &value : times.values) {
+    if (!LinuxParser::ParseNumber(first, last, value)) {
+      break;
     }
-
-    return !str.empty();
+  }
 }
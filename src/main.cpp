@@ -1,7 +1,345 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "collector.h"
+#include "exporter.h"
+#include "linux_parser.h"
 #include "ncurses_display.h"
+#include "player.h"
+#include "recorder.h"
 #include "system.h"
 
-int main() {
-  System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+namespace {
+struct Options_t {
+  unsigned workers = 1;      // threads scanning /proc/pid, see ScanPool
+  bool headless = false;     // stream records instead of the ncurses UI
+  bool stats = false;        // show or export the tick profile
+  bool events = false;       // follow pids with the proc connector
+  bool fullScan = false;     // read every process every tick
+  bool pss = false;          // sample PSS/USS, see MemorySampler
+  long pssBudgetUs = 2000;   // sampler CPU time per tick
+  long pssTop = 10;          // processes by RSS sampled every tick
+  bool io = false;           // read /proc/pid/io for I/O rates
+  // order of the process rows, see ProcessTable::Order
+  ProcessTable::Order sort = ProcessTable::Order::kCpu;
+  ExportFormat format = ExportFormat::kNdjson;
+  std::string output;        // headless output file, stdout if empty
+  long intervalMs = 1000;    // sampling period
+  long top = 10;             // process rows per tick, 0 for all
+  long count = 0;            // headless ticks to write, 0 for no limit
+  std::string record;        // recording file, see Recorder
+  std::string replay;        // recording played back instead of /proc
+  std::string seek;          // replay start, "+SECONDS" or "HH:MM:SS"
+  std::string procRoot;      // replaces /proc, see Fixture
+  std::string passwd;        // replaces /etc/passwd
+  std::string osRelease;     // replaces /etc/os-release
+};
+
+std::atomic<bool> stopRequested{false};
+
+void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [--workers N] [--interval MS] [--top N|--all] [--stats]\n"
+          "          [--events] [--full-scan] [--pss [--pss-budget US] [--pss-top N]]\n"
+          "          [--io] [--sort cpu|rss|io|pid]\n"
+          "          [--proc-root DIR] [--passwd FILE] [--os-release FILE]\n"
+          "          [--record FILE] [--headless [--format ndjson|csv]\n"
+          "          [--output FILE] [--count N]]\n"
+          "       %s --replay FILE [--seek +SECONDS|HH:MM:SS]\n",
+          program, program);
+}
+
+/**
+ * @brief Parses the value of --sort
+ *
+ * @param name : "cpu", "rss", "io" or "pid"
+ * @param order : Order parsed
+ * @return {bool} : false if the name is unknown
+ */
+bool parseOrder(const char *name, ProcessTable::Order &order) {
+  static const std::pair<const char *, ProcessTable::Order> kOrders[]{
+      {"cpu", ProcessTable::Order::kCpu},
+      {"rss", ProcessTable::Order::kRss},
+      {"io", ProcessTable::Order::kIo},
+      {"pid", ProcessTable::Order::kPid}};
+  for (const auto &[text, value] : kOrders) {
+    if (strcmp(name, text) == 0) {
+      order = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Parses the command line
+ *
+ * @return {bool} : false if an argument is not understood
+ */
+bool parseOptions(int argc, char *argv[], Options_t &options) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--headless") == 0) {
+      options.headless = true;
+    } else if (strcmp(arg, "--events") == 0) {
+      options.events = true;
+    } else if (strcmp(arg, "--stats") == 0) {
+      options.stats = true;
+    } else if (strcmp(arg, "--full-scan") == 0) {
+      options.fullScan = true;
+    } else if (strcmp(arg, "--pss") == 0) {
+      options.pss = true;
+    } else if (strcmp(arg, "--io") == 0) {
+      options.io = true;
+    } else if (strcmp(arg, "--all") == 0) {
+      options.top = 0;
+    } else if (value == nullptr) {
+      return false;
+    } else if (strcmp(arg, "--workers") == 0) {
+      options.workers = std::max(1l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(arg, "--format") == 0) {
+      if (!Exporter::ParseFormat(value, options.format)) {
+        return false;
+      }
+      i++;
+    } else if (strcmp(arg, "--sort") == 0) {
+      if (!parseOrder(value, options.sort)) {
+        return false;
+      }
+      i++;
+    } else if (strcmp(arg, "--record") == 0) {
+      options.record = value;
+      i++;
+    } else if (strcmp(arg, "--replay") == 0) {
+      options.replay = value;
+      i++;
+    } else if (strcmp(arg, "--seek") == 0) {
+      options.seek = value;
+      i++;
+    } else if (strcmp(arg, "--proc-root") == 0) {
+      options.procRoot = value;
+      i++;
+    } else if (strcmp(arg, "--passwd") == 0) {
+      options.passwd = value;
+      i++;
+    } else if (strcmp(arg, "--os-release") == 0) {
+      options.osRelease = value;
+      i++;
+    } else if (strcmp(arg, "--output") == 0) {
+      options.output = value;
+      i++;
+    } else if (strcmp(arg, "--interval") == 0) {
+      options.intervalMs = std::max(1l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(arg, "--top") == 0) {
+      options.top = std::max(0l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(arg, "--pss-budget") == 0) {
+      options.pssBudgetUs = std::max(1l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(arg, "--pss-top") == 0) {
+      options.pssTop = std::max(0l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(arg, "--count") == 0) {
+      options.count = std::max(0l, strtol(value, nullptr, 10));
+      i++;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Samples until interrupted or until options.count ticks are done,
+ * streaming records and/or recording them
+ *
+ * @return {int} : Exit status
+ */
+int run(System &system, const Options_t &options) {
+  Recorder recorder;
+  if (!options.record.empty() && !recorder.Open(options.record)) {
+    perror(options.record.c_str());
+    return EXIT_FAILURE;
+  }
+
+  FILE *out = stdout;
+  if (options.headless && !options.output.empty()) {
+    out = fopen(options.output.c_str(), "a");
+    if (out == nullptr) {
+      perror(options.output.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  std::optional<Exporter> exporter;
+  if (options.headless) {
+    exporter.emplace(options.format, out, options.stats);
+  }
+
+  std::atomic<long> sampled{0};
+  std::atomic<bool> failed{false};
+  /* Cleared, after recordError is set, when an Append fails */
+  std::atomic<bool> recording{!options.record.empty()};
+  std::string recordError;
+  size_t rows = options.top > 0 ? size_t(options.top) : SIZE_MAX;
+  Collector collector(system, rows,
+                      std::chrono::milliseconds(options.intervalMs));
+  bool const limited = options.headless && options.count > 0;
+  collector.OnSample([&](const Snapshot_t &snapshot) {
+    /* Ticks published before the main thread stops the collector */
+    if (limited && sampled >= options.count) {
+      return;
+    }
+    if (recording && !recorder.Append(snapshot)) {
+      recordError = "recording stopped: ";
+      recordError += recorder.Full() ? "index full" : strerror(errno);
+      recording = false;
+      failed = true;
+    }
+    if (exporter && !exporter->Write(snapshot)) {
+      failed = true;
+    }
+    sampled++;
+    if (limited && sampled == options.count) {
+      stopRequested = true;
+    }
+  });
+
+  collector.Start();
+
+  if (options.headless) {
+    signal(SIGINT, [](int) { stopRequested = true; });
+    signal(SIGTERM, [](int) { stopRequested = true; });
+    while (!stopRequested && !failed) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  } else {
+    NCursesDisplay::Display(
+        collector, rows > 10 ? 10 : rows, options.stats, [&] {
+          bool const stopped = !options.record.empty() && !recording;
+          return stopped ? recordError : std::string();
+        });
+  }
+  collector.Stop();
+  recorder.Close();
+  if (!recordError.empty()) {
+    fprintf(stderr, "%s: %s\n", options.record.c_str(), recordError.c_str());
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+/**
+ * @brief Converts the --seek argument into a recording time
+ * "+SECONDS" is an offset from the first tick, "HH:MM:SS" a wall clock
+ * time on the day the recording started.
+ *
+ * @return {bool} : false if the argument cannot be parsed
+ */
+bool parseSeek(const std::string &seek, const Player &player,
+               std::int64_t &timeNs) {
+  std::int64_t const first = player.TimeNs(0);
+  timeNs = first;
+  if (seek.empty()) {
+    return true;
+  }
+  if (seek[0] == '+') {
+    char *end = nullptr;
+    double seconds = strtod(seek.c_str() + 1, &end);
+    timeNs = first + std::int64_t(seconds * 1e9);
+    return *end == '\0';
+  }
+
+  int hours, minutes, seconds;
+  if (sscanf(seek.c_str(), "%d:%d:%d", &hours, &minutes, &seconds) != 3) {
+    return false;
+  }
+  time_t start = (first + player.WallClockOffsetNs()) / 1000000000;
+  struct tm local;
+  localtime_r(&start, &local);
+  local.tm_hour = hours;
+  local.tm_min = minutes;
+  local.tm_sec = seconds;
+  timeNs = std::int64_t(mktime(&local)) * 1000000000 -
+           player.WallClockOffsetNs();
+  return true;
+}
+
+/**
+ * @brief Plays a recording back in the ncurses display
+ *
+ * @return {int} : Exit status
+ */
+int replay(const Options_t &options) {
+  Player player;
+  if (!player.Open(options.replay)) {
+    fprintf(stderr, "%s: not a readable recording\n", options.replay.c_str());
+    return EXIT_FAILURE;
+  }
+  std::int64_t start;
+  if (!parseSeek(options.seek, player, start)) {
+    fprintf(stderr, "invalid --seek value: %s\n", options.seek.c_str());
+    return EXIT_FAILURE;
+  }
+  NCursesDisplay::Replay(player, start);
+  return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options_t options;
+  if (!parseOptions(argc, argv, options)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (!options.replay.empty()) {
+    return replay(options);
+  }
+
+  if (!options.procRoot.empty()) {
+    LinuxParser::SetProcDirectory(options.procRoot);
+  }
+  if (!options.passwd.empty()) {
+    LinuxParser::SetPasswordPath(options.passwd);
+  }
+  if (!options.osRelease.empty()) {
+    LinuxParser::SetOSPath(options.osRelease);
+  }
+
+  /* The connector reports the pids of the host, not of a fixture */
+  bool events = options.events && options.procRoot.empty();
+  if (options.events && !events) {
+    fprintf(stderr, "--events ignored with --proc-root\n");
+  }
+  System system(options.workers, events, !options.fullScan);
+  if (events && !system.EventsActive()) {
+    fprintf(stderr, "proc connector unavailable, scanning /proc\n");
+  }
+  if (options.pss) {
+    system.SampleMemory(std::chrono::microseconds(options.pssBudgetUs),
+                        size_t(options.pssTop));
+  }
+  /* Sorting by I/O needs the rates */
+  if (options.io || options.sort == ProcessTable::Order::kIo) {
+    system.SampleIo();
+  }
+  system.SortBy(options.sort);
+  return run(system, options);
+}
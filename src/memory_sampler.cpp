@@ -0,0 +1,100 @@
+#include "memory_sampler.h"
+
+#include <time.h>
+
+#include "linux_parser.h"
+
+using std::size_t;
+using std::chrono::steady_clock;
+
+/**
+ * @brief CPU time consumed by the calling thread, smaps_rollup is built
+ * in the kernel on behalf of the reader so it is accounted here
+ *
+ * @return {nanoseconds} : Thread CPU time
+ */
+static std::chrono::nanoseconds threadCpuTime();
+
+/**
+ * @brief Whether a row is worth a smaps_rollup read
+ *
+ * @return {bool} : false without an address space or after a failed read
+ */
+static bool sampleable(const ProcessTable &table, size_t row);
+
+/**
+ * @brief Construct a new MemorySampler object
+ *
+ * @param budget : CPU time the sampling thread may spend per tick
+ * @param top : Number of processes with the highest RSS refreshed
+ * every tick
+ */
+MemorySampler::MemorySampler(std::chrono::microseconds budget, size_t top)
+    : budget_(budget), top_(top) {}
+
+/**
+ * @brief Refreshes the PSS and USS of as many processes as the budget
+ * allows, the top-K by RSS first. Processes without an address space
+ * are skipped, as are those whose smaps_rollup could not be read
+ * (no ptrace access) until their pid is reused.
+ *
+ * @param table : Process table just refreshed
+ */
+void MemorySampler::Sample(ProcessTable &table) {
+  auto const deadline = threadCpuTime() + budget_;
+  auto const now = steady_clock::now();
+
+  /* Rows read this tick carry its time, the walk below skips them */
+  for (size_t row : table.Top(top_, ProcessTable::Order::kRss)) {
+    if (!sampleable(table, row)) {
+      continue;
+    }
+    if (threadCpuTime() >= deadline) {
+      return;
+    }
+    Refresh(table, row, now);
+  }
+
+  size_t const size = table.Size();
+  size_t row = table.LowerBound(nextPid_);
+  for (size_t visited = 0; visited < size; visited++, row++) {
+    if (row >= size) {
+      row = 0;
+    }
+    if (table.MemorySampledAt(row) == now || !sampleable(table, row)) {
+      continue;
+    }
+    if (threadCpuTime() >= deadline) {
+      nextPid_ = table.Pid(row);
+      return;
+    }
+    Refresh(table, row, now);
+  }
+}
+
+/**
+ * @brief Reads smaps_rollup for one row of the table
+ */
+void MemorySampler::Refresh(ProcessTable &table, size_t row,
+                            steady_clock::time_point now) {
+  LinuxParser::SmapsRollup_t rollup;
+  if (LinuxParser::ReadSmapsRollup(table.Pid(row), rollup)) {
+    table.SetMemory(row, rollup.pss, rollup.Uss(), now);
+  } else {
+    table.SetMemory(row, -1, -1, now);
+  }
+}
+
+static std::chrono::nanoseconds threadCpuTime() {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return std::chrono::seconds(time.tv_sec) +
+         std::chrono::nanoseconds(time.tv_nsec);
+}
+
+static bool sampleable(const ProcessTable &table, size_t row) {
+  bool const failed = table.Pss(row) < 0 &&
+                      table.MemorySampledAt(row) !=
+                          steady_clock::time_point{};
+  return table.Rss(row) > 0 && !failed;
+}
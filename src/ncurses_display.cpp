@@ -1,115 +1,429 @@
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <ctime>
 #include <curses.h>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
+#include "collector.h"
 #include "format.h"
 #include "ncurses_display.h"
 #include "system.h"
 
 using std::string;
-using std::to_string;
+
+// Per-core grid cell: "NNN[" + bars + "] "
+static constexpr int kCoreBarWidth{8};
+static constexpr int kCoreCellWidth{4 + kCoreBarWidth + 2};
+// Rows of the system window that are not part of the core grid
+static constexpr int kSystemRows{10};
+// Stats panel: borders, header, one row per stage and the syscalls
+static constexpr int kStatsRows{3 + int(kTickStages) + 1};
+// PSS values older than this are marked with a '*'
+static constexpr float kStalePssSeconds{10.0f};
 
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
-std::string NCursesDisplay::ProgressBar(float percent) {
-  std::string result{"0%"};
-  int size{50};
-  float bars{percent * size};
+void NCursesDisplay::ProgressBar(float percent, FrameModel &frame, int y,
+                                 int x) {
+  static const char kBars[]{"||||||||||||||||||||||||||||||||||||||||||||||||||"};
+  int const size{50};
+  float const bars{percent * size};
+  int const filled = std::clamp(int(bars) + 1, 0, size);
 
-  for (int i{0}; i < size; ++i) {
-    result += i <= bars ? '|' : ' ';
+  frame.Put(y, x, "0%", 1);
+  frame.Put(y, x + 2, std::string_view(kBars, filled), 1);
+  x += 2 + size + 1;
+  /* 4 cells: "23.0", " 5.2" or " 100" */
+  float const value = percent * 100;
+  if (percent == 1.0) {
+    frame.Put(y, x, " 100", 1);
+  } else if (percent < 0.1) {
+    frame.PutFixed(y, x, value, 1, 4, 1);
+  } else {
+    frame.PutFixed(y, x, value, 1, 0, 1);
   }
+  frame.Put(y, x + 4, "/100%", 1);
+}
+
+void NCursesDisplay::DisplaySystem(const Snapshot_t &snapshot,
+                                   FrameModel &frame) {
+  int row{0};
+  char time[Format::kElapsedTimeSize];
+
+  frame.Put(++row, 2, "OS: ");
+  frame.Put(row, 6, snapshot.operatingSystem);
+  frame.Put(++row, 2, "Kernel: ");
+  frame.Put(row, 10, snapshot.kernel);
+
+  frame.Put(++row, 2, "CPU: ");
+  ProgressBar(snapshot.cpu.total, frame, row, 10);
+  const CpuLoad_t &load = snapshot.cpu;
+  float const shares[]{load.user, load.system, load.iowait, load.steal};
+  const char *const labels[]{"us ", "sy ", "wa ", "st "};
+  ++row;
+  for (int i = 0; i < 4; ++i) {
+    int const x = 10 + i * 11;
+    frame.Put(row, x, labels[i]);
+    frame.PutFixed(row, x + 3, shares[i] * 100, 1, 5);
+    frame.Put(row, x + 8, "%");
+  }
+
+  frame.Put(++row, 2, "Memory: ");
+  ProgressBar(snapshot.memory, frame, row, 10);
 
-  string display{to_string(percent * 100).substr(0, 4)};
-  if (percent < 0.1 || percent == 1.0)
-    display = " " + to_string(percent * 100).substr(0, 3);
-  return result + " " + display + "/100%";
+  frame.Put(++row, 2, "Total Processes: ");
+  frame.PutInteger(row, 19, snapshot.totalProcesses);
+  frame.Put(++row, 2, "Running Processes: ");
+  frame.PutInteger(row, 21, snapshot.runningProcesses);
+  frame.Put(++row, 2, "Up Time: ");
+  frame.Put(row, 11, Format::ElapsedTime(snapshot.uptime, time));
+  DisplayCoreGrid(snapshot.cores, frame, frame.Width(), ++row);
 }
 
-void NCursesDisplay::DisplaySystem(System &system, WINDOW *window) {
-    int row{0};
-    
-    mvwprintw(window, ++row, 2, "%s", ("OS: " + system.OperatingSystem()).c_str());
-    mvwprintw(window, ++row, 2, "%s", ("Kernel: " + system.Kernel()).c_str());
-    
-    mvwprintw(window, ++row, 2, "CPU: ");
-    wattron(window, COLOR_PAIR(1));
-    mvwprintw(window, row, 10, "%s", ProgressBar(system.Cpu().Utilization()).c_str());
-    wattroff(window, COLOR_PAIR(1));
-    
-    mvwprintw(window, ++row, 2, "Memory: ");
-    wattron(window, COLOR_PAIR(1));
-    mvwprintw(window, row, 10, "%s", ProgressBar(system.MemoryUtilization()).c_str());
-    wattroff(window, COLOR_PAIR(1));
-    
-    mvwprintw(window, ++row, 2, "%s", 
-              ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-    mvwprintw(window, ++row, 2, "%s",
-              ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-    mvwprintw(window, ++row, 2, "%s",
-              ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
-    
-    wrefresh(window);
+// Number of grid rows needed to show nbCores cells in a window of the
+// given width
+int NCursesDisplay::CoreGridRows(int nbCores, int width) {
+  int columns = std::max(1, (width - 4) / kCoreCellWidth);
+  return (nbCores + columns - 1) / columns;
 }
 
-void NCursesDisplay::DisplayProcesses(std::vector<Process> &processes,
-                                      WINDOW *window, int n) {
+// One cell per core, the bar is stacked user (green), system (red),
+// iowait (yellow) and steal (magenta)
+void NCursesDisplay::DisplayCoreGrid(const std::vector<CpuLoad_t> &cores,
+                                     FrameModel &frame, int width, int row) {
+  static const char kBars[kCoreBarWidth + 1]{"||||||||"};
+  int const columns = std::max(1, (width - 4) / kCoreCellWidth);
+
+  for (int i = 0; i < int(cores.size()); ++i) {
+    int const y = row + i / columns;
+    int x = 2 + (i % columns) * kCoreCellWidth;
+    const CpuLoad_t &core = cores[i];
+    float const shares[] = {core.user, core.system, core.iowait, core.steal};
+
+    frame.PutInteger(y, x, i, 3);
+    frame.Put(y, x + 3, "[");
+    x += 4;
+    int used = 0;
+    for (int s = 0; s < 4; ++s) {
+      int bars = std::min(kCoreBarWidth - used,
+                          int(shares[s] * kCoreBarWidth + 0.5f));
+      if (bars > 0) {
+        frame.Put(y, x + used, std::string_view(kBars, bars), 3 + s);
+        used += bars;
+      }
+    }
+    frame.Put(y, x + kCoreBarWidth, "]");
+  }
+}
+
+// The PSS column is only shown when the memory sampler runs, the I/O
+// columns when I/O is sampled
+void NCursesDisplay::DisplayProcesses(const std::vector<ProcessRow_t> &processes,
+                                      FrameModel &frame, int n, bool pss,
+                                      bool io) {
     int row{0};
     int const pid_column{2};
     int const user_column{9};
     int const cpu_column{16};
     int const ram_column{26};
-    int const time_column{35};
-    int const command_column{46};
-    
-    wattron(window, COLOR_PAIR(2));
-    mvwprintw(window, ++row, pid_column, "PID");
-    mvwprintw(window, row, user_column, "USER");
-    mvwprintw(window, row, cpu_column, "CPU[%%]");
-    mvwprintw(window, row, ram_column, "RAM[MB]");
-    mvwprintw(window, row, time_column, "TIME+");
-    mvwprintw(window, row, command_column, "COMMAND");
-    wattroff(window, COLOR_PAIR(2));
+    int const pss_column{35};
+    int const read_column{pss ? 44 : 35};
+    int const write_column{read_column + 11};
+    int const time_column{io ? write_column + 12 : read_column};
+    int const command_column{time_column + 11};
+    char time[Format::kElapsedTimeSize];
+
+    frame.Put(++row, pid_column, "PID", 2);
+    frame.Put(row, user_column, "USER", 2);
+    frame.Put(row, cpu_column, "CPU[%]", 2);
+    frame.Put(row, ram_column, "RAM[MB]", 2);
+    if (pss) {
+        frame.Put(row, pss_column, "PSS[MB]", 2);
+    }
+    if (io) {
+        frame.Put(row, read_column, "READ[KB/s]", 2);
+        frame.Put(row, write_column, "WRITE[KB/s]", 2);
+    }
+    frame.Put(row, time_column, "TIME+", 2);
+    frame.Put(row, command_column, "COMMAND", 2);
 
     int const num_processes = int(processes.size()) > n ? n : processes.size();
     for (int i = 0; i < num_processes; ++i) {
-        mvwprintw(window, ++row, pid_column, "%s", to_string(processes[i].Pid()).c_str());
-        mvwprintw(window, row, user_column, "%s", processes[i].User().c_str());
-        float cpu = processes[i].CpuUtilization() * 100;
-        mvwprintw(window, row, cpu_column, "%s", to_string(cpu).substr(0, 4).c_str());
-        mvwprintw(window, row, ram_column, "%s", processes[i].Ram().c_str());
-        mvwprintw(window, row, time_column, "%s", 
-                 Format::ElapsedTime(processes[i].UpTime()).c_str());
-        mvwprintw(window, row, command_column, "%s",
-                 processes[i].Command().substr(0, window->_maxx - 46).c_str());
+        const ProcessRow_t &process = processes[i];
+        frame.PutInteger(++row, pid_column, process.pid);
+        frame.Put(row, user_column, process.user, 0,
+                  cpu_column - user_column - 1);
+        /* 4 cells as before: "0.00", "12.3", "123." */
+        float cpu = process.cpu * 100;
+        frame.PutFixed(row, cpu_column, cpu,
+                       cpu < 10 ? 2 : (cpu < 100 ? 1 : 0));
+        if (process.ramKb >= 0) {
+            frame.PutInteger(row, ram_column, process.ramKb / 1024);
+        } else {
+            frame.Put(row, ram_column, "N/A");
+        }
+        if (pss && process.pssKb >= 0) {
+            long const pssMb = process.pssKb / 1024;
+            frame.PutInteger(row, pss_column, pssMb);
+            /* Stale marker right after the digits */
+            if (process.memoryAge > kStalePssSeconds) {
+                int digits = 1;
+                for (long rest = pssMb; rest >= 10; rest /= 10) {
+                    digits++;
+                }
+                frame.Put(row, pss_column + digits, "*");
+            }
+        } else if (pss) {
+            frame.Put(row, pss_column, "-");
+        }
+        if (io && process.readBps >= 0) {
+            frame.PutInteger(row, read_column, process.readBps / 1024);
+            frame.PutInteger(row, write_column, process.writeBps / 1024);
+        } else if (io) {
+            frame.Put(row, read_column, "-");
+            frame.Put(row, write_column, "-");
+        }
+        frame.Put(row, time_column, Format::ElapsedTime(process.uptime, time));
+        frame.Put(row, command_column, process.command);
+    }
+}
+
+// Stage timings in microseconds, rolling over the profiler window
+void NCursesDisplay::DisplayStats(const TickProfile_t &profile,
+                                  FrameModel &frame) {
+  static const char *const kColumns[]{"LAST[us]", "P50[us]", "P99[us]",
+                                      "MAX[us]"};
+  int row{0};
+  frame.Put(++row, 2, "STAGE", 2);
+  for (int c = 0; c < 4; ++c) {
+    std::string_view column = kColumns[c];
+    frame.Put(row, 14 + c * 10 + 10 - int(column.size()), column, 2);
+  }
+  for (size_t i = 0; i <= kTickStages; ++i) {
+    bool const syscalls = i == kTickStages;
+    const Percentiles_t &value =
+        syscalls ? profile.syscalls : profile.stages[i];
+    std::int64_t const values[]{value.last, value.p50, value.p99, value.max};
+    frame.Put(++row, 2,
+              syscalls ? "rw syscalls"
+                       : TickProfiler::StageName(static_cast<TickStage>(i)));
+    for (int c = 0; c < 4; ++c) {
+      if (syscalls) {
+        frame.PutInteger(row, 14 + c * 10, values[c], 10);
+      } else {
+        frame.PutFixed(row, 14 + c * 10, values[c] / 1e3, 1, 10);
+      }
     }
+  }
 }
 
-void NCursesDisplay::Display(System &system, int n) {
+namespace {
+// Windows and the frame last drawn in each of them
+struct Windows_t {
+  WINDOW *system;
+  WINDOW *process;
+  WINDOW *stats; // null when the panel is off
+  WINDOW *status;
+  FrameModel systemFrame;
+  FrameModel processFrame;
+  FrameModel statsFrame;
+  FrameModel statusFrame;
+};
 
+// Starts ncurses and lays out the windows, the system window is sized
+// for the core grid of the first snapshot. Colors and borders never
+// change so they are set up here, once.
+Windows_t openWindows(const Snapshot_t &snapshot, int n, bool stats) {
   initscr();     // start ncurses
   noecho();      // do not print input values
   cbreak();      // terminate ncurses on ctrl + c
   start_color(); // enable color
+  curs_set(0);   // the cursor would move with every changed cell
+
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  init_pair(3, COLOR_GREEN, COLOR_BLACK);
+  init_pair(4, COLOR_RED, COLOR_BLACK);
+  init_pair(5, COLOR_YELLOW, COLOR_BLACK);
+  init_pair(6, COLOR_MAGENTA, COLOR_BLACK);
 
   int x_max{getmaxx(stdscr)};
-  WINDOW *system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW *process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
-
-  while (1) {
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
-    wrefresh(system_window);
-    wrefresh(process_window);
-    refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  int const grid_rows =
+      NCursesDisplay::CoreGridRows(snapshot.cores.size(), x_max - 1);
+  Windows_t windows;
+  windows.system = newwin(kSystemRows + grid_rows, x_max - 1, 0, 0);
+  windows.process =
+      newwin(3 + n, x_max - 1, windows.system->_maxy + 1, 0);
+  int y = windows.system->_maxy + windows.process->_maxy + 2;
+  windows.stats = nullptr;
+  if (stats) {
+    windows.stats = newwin(kStatsRows, x_max - 1, y, 0);
+    y += kStatsRows;
+  }
+  windows.status = newwin(1, x_max - 1, y, 0);
+  // Keys are polled from the status window so stdscr is never refreshed
+  // over the other windows
+  nodelay(windows.status, TRUE);
+  keypad(windows.status, TRUE);
+
+  for (WINDOW *window : {windows.system, windows.process, windows.stats}) {
+    if (window != nullptr) {
+      box(window, 0, 0);
+      wnoutrefresh(window);
+    }
+  }
+  windows.systemFrame = FrameModel(windows.system, 1);
+  windows.processFrame = FrameModel(windows.process, 1);
+  windows.statsFrame = FrameModel(windows.stats, 1);
+  windows.statusFrame = FrameModel(windows.status, 0);
+  return windows;
+}
+
+// Composes the whole frame in the models, only the cells that changed
+// reach the terminal
+void render(const Snapshot_t &snapshot, Windows_t &windows, int n) {
+  windows.systemFrame.Clear();
+  NCursesDisplay::DisplaySystem(snapshot, windows.systemFrame);
+  windows.systemFrame.Flush();
+  windows.processFrame.Clear();
+  NCursesDisplay::DisplayProcesses(snapshot.processes, windows.processFrame,
+                                   n, snapshot.memorySampled,
+                                   snapshot.ioSampled);
+  windows.processFrame.Flush();
+  if (windows.stats != nullptr) {
+    windows.statsFrame.Clear();
+    NCursesDisplay::DisplayStats(snapshot.profile, windows.statsFrame);
+    windows.statsFrame.Flush();
+  }
+  doupdate();
+}
+
+// Wall clock time of a recorded tick as "YYYY-MM-DD HH:MM:SS"
+string wallClock(std::int64_t ns) {
+  time_t seconds = ns / 1000000000;
+  struct tm local;
+  char text[32]{};
+  localtime_r(&seconds, &local);
+  strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+  return text;
+}
+} // namespace
+
+// Sampling runs on the collector thread, this loop only renders snapshots
+// The render time of a frame is added to the profiler tick in progress
+// notice, checked on every new tick, is shown on the status line when
+// not empty (a recording that stopped)
+void NCursesDisplay::Display(Collector &collector, int n, bool stats,
+                             std::function<std::string()> notice) {
+  std::shared_ptr<const Snapshot_t> snapshot;
+  while ((snapshot = collector.Latest()) == nullptr) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  Windows_t windows = openWindows(*snapshot, n, stats);
+  windows.statusFrame.Put(0, 2, "q: quit");
+  windows.statusFrame.Flush();
+  doupdate();
+
+  std::uint64_t drawn_tick{UINT64_MAX};
+  std::string shown;
+  while (wgetch(windows.status) != 'q') {
+    snapshot = collector.Latest();
+    if (snapshot->tick != drawn_tick) {
+      drawn_tick = snapshot->tick;
+      std::string text = notice ? notice() : std::string();
+      if (text != shown) {
+        shown = text;
+        windows.statusFrame.Clear();
+        windows.statusFrame.Put(0, 2, "q: quit");
+        windows.statusFrame.Put(0, 11, shown, 4);
+        windows.statusFrame.Flush();
+      }
+      TickProfiler::Timer timer(collector.Profiler(), TickStage::kRender);
+      render(*snapshot, windows, n);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  endwin();
+}
+
+// Playback keeps a position in recording time which advances with the
+// wall clock times the speed, the tick shown is the last one taken at or
+// before that position
+void NCursesDisplay::Replay(Player &player, std::int64_t startNs, int n) {
+  using std::chrono::steady_clock;
+  static const int kSpeeds[]{1, 10, 100};
+  std::int64_t const first = player.TimeNs(0);
+  std::int64_t const last = player.TimeNs(player.TickCount() - 1);
+  std::int64_t position = std::clamp(startNs, first, last);
+  int speed = 1;
+  bool paused = false;
+
+  size_t tick = player.Seek(position);
+  std::shared_ptr<const Snapshot_t> snapshot = player.Load(tick);
+  /* Recordings do not keep the profile */
+  Windows_t windows = openWindows(*snapshot, n, false);
+  render(*snapshot, windows, n);
+
+  auto previous = steady_clock::now();
+  bool dirty = true;
+  while (true) {
+    int key = wgetch(windows.status);
+    std::int64_t seek = 0;
+    if (key == 'q') {
+      break;
+    } else if (key == ' ') {
+      paused = !paused;
+    } else if (key >= '1' && key <= '3') {
+      speed = kSpeeds[key - '1'];
+    } else if (key == KEY_RIGHT) {
+      seek = 10;
+    } else if (key == KEY_LEFT) {
+      seek = -10;
+    } else if (key == KEY_UP) {
+      seek = 60;
+    } else if (key == KEY_DOWN) {
+      seek = -60;
+    }
+    dirty |= key != ERR;
+
+    auto now = steady_clock::now();
+    if (!paused) {
+      position += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      now - previous)
+                      .count() *
+                  speed;
+    }
+    previous = now;
+    position = std::clamp(position + seek * 1000000000, first, last);
+
+    size_t const at = player.Seek(position);
+    if (at != tick) {
+      tick = at;
+      snapshot = player.Load(tick);
+      render(*snapshot, windows, n);
+      dirty = true;
+    }
+    if (dirty) {
+      char status[256];
+      int length = snprintf(
+          status, sizeof(status),
+          "%s  tick %zu/%zu  %dx%s  q:quit space:pause 1/2/3:speed "
+          "arrows:seek",
+          wallClock(snapshot->sampledAtNs + player.WallClockOffsetNs())
+              .c_str(),
+          tick + 1, player.TickCount(), speed, paused ? " (paused)" : "");
+      windows.statusFrame.Clear();
+      windows.statusFrame.Put(
+          0, 2, std::string_view(status, std::min<int>(length, sizeof(status) - 1)));
+      windows.statusFrame.Flush();
+      doupdate();
+      dirty = false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
   }
   endwin();
 }
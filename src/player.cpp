@@ -0,0 +1,178 @@
+#include "player.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Recording;
+
+/**
+ * @brief Unmaps the recording
+ */
+Player::~Player() { Close(); }
+
+/**
+ * @brief Maps a recording and checks its header
+ *
+ * @param path : Path of the recording
+ * @return {bool} : false if the file is missing or is not a recording
+ */
+bool Player::Open(const std::string &path) {
+  Close();
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info = {};
+  if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(Header_t)) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  map_ = static_cast<const char *>(map);
+  size_ = info.st_size;
+
+  /* Ticks are read through the index, it is mostly accessed at random */
+  madvise(map, size_, MADV_RANDOM);
+
+  memcpy(&header_, map_, sizeof(header_));
+  bool valid =
+      memcmp(header_.magic, kMagic, sizeof(kMagic)) == 0 &&
+      header_.version == kVersion && header_.tickCount > 0 &&
+      header_.tickCount <= header_.indexCapacity &&
+      header_.indexOffset + header_.indexCapacity * sizeof(IndexEntry_t) <=
+          header_.dataOffset &&
+      header_.dataOffset <= header_.dataEnd && header_.dataEnd <= size_;
+  if (!valid) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the number of ticks in the recording
+ *
+ * @return {size_t} : Number of committed ticks
+ */
+std::size_t Player::TickCount() const { return header_.tickCount; }
+
+/**
+ * @brief Returns the monotonic time of a tick
+ *
+ * @param tick : Tick number, lower than TickCount()
+ * @return {int64_t} : Time of the tick in nanoseconds
+ */
+std::int64_t Player::TimeNs(std::size_t tick) const {
+  return Entry(tick).timeNs;
+}
+
+/**
+ * @brief Returns the offset to add to a tick time to get the wall clock
+ * time (nanoseconds since the epoch)
+ *
+ * @return {int64_t} : Offset in nanoseconds
+ */
+std::int64_t Player::WallClockOffsetNs() const {
+  return header_.wallClockOffsetNs;
+}
+
+/**
+ * @brief Finds the last tick taken at or before a time
+ * Binary search over the index, O(log n).
+ *
+ * @param timeNs : Monotonic time in nanoseconds
+ * @return {size_t} : Tick number, 0 if the time is before the first tick
+ */
+std::size_t Player::Seek(std::int64_t timeNs) const {
+  const IndexEntry_t *first =
+      reinterpret_cast<const IndexEntry_t *>(map_ + header_.indexOffset);
+  const IndexEntry_t *last = first + header_.tickCount;
+  const IndexEntry_t *after = std::upper_bound(
+      first, last, timeNs, [](std::int64_t time, const IndexEntry_t &entry) {
+        return time < entry.timeNs;
+      });
+  return after == first ? 0 : (after - first) - 1;
+}
+
+/**
+ * @brief Rebuilds the snapshot of a tick
+ *
+ * @param tick : Tick number, lower than TickCount()
+ * @return {std::shared_ptr<const Snapshot_t>} : The recorded snapshot
+ */
+std::shared_ptr<const Snapshot_t> Player::Load(std::size_t tick) const {
+  auto snapshot = std::make_shared<Snapshot_t>();
+  const IndexEntry_t &entry = Entry(tick);
+  if (entry.offset + sizeof(TickRecord_t) > header_.dataEnd) {
+    return snapshot;
+  }
+
+  TickRecord_t record;
+  memcpy(&record, map_ + entry.offset, sizeof(record));
+  std::uint64_t size = TickSize(record.coreCount, record.processCount);
+  if (entry.offset + size > header_.dataEnd) {
+    return snapshot;
+  }
+
+  snapshot->tick = record.tick;
+  snapshot->sampledAtNs = record.timeNs;
+  snapshot->jitterNs = record.jitterNs;
+  /* Header fields may fill their whole size without a NUL */
+  snapshot->operatingSystem.assign(
+      header_.operatingSystem,
+      strnlen(header_.operatingSystem, sizeof(header_.operatingSystem)));
+  snapshot->kernel.assign(header_.kernel,
+                          strnlen(header_.kernel, sizeof(header_.kernel)));
+  snapshot->cpu = record.cpu;
+  snapshot->memory = record.memory;
+  snapshot->totalProcesses = record.totalProcesses;
+  snapshot->runningProcesses = record.runningProcesses;
+  snapshot->uptime = record.uptime;
+
+  const char *cores = map_ + entry.offset + sizeof(record);
+  snapshot->cores.resize(record.coreCount);
+  memcpy(snapshot->cores.data(), cores, record.coreCount * sizeof(CpuLoad_t));
+
+  const char *rows = map_ + entry.offset + size -
+                     record.processCount * sizeof(ProcessRecord_t);
+  snapshot->processes.resize(record.processCount);
+  for (ProcessRow_t &row : snapshot->processes) {
+    ProcessRecord_t process;
+    memcpy(&process, rows, sizeof(process));
+    rows += sizeof(process);
+    /* Fields are NUL terminated by the recorder, don't trust it blindly */
+    process.user[sizeof(process.user) - 1] = '\0';
+    process.command[sizeof(process.command) - 1] = '\0';
+
+    row.pid = process.pid;
+    row.user = process.user;
+    row.cpu = process.cpu;
+    /* Recordings keep the resident memory only, to the Mb */
+    row.ramKb = process.ramMb >= 0 ? process.ramMb * 1024 : -1;
+    row.uptime = process.uptime;
+    row.command = process.command;
+  }
+
+  return snapshot;
+}
+
+void Player::Close() {
+  if (map_ != nullptr) {
+    munmap(const_cast<char *>(map_), size_);
+    map_ = nullptr;
+    size_ = 0;
+  }
+}
+
+const IndexEntry_t &Player::Entry(std::size_t tick) const {
+  return reinterpret_cast<const IndexEntry_t *>(map_ +
+                                                header_.indexOffset)[tick];
+}
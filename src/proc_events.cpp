@@ -0,0 +1,546 @@
+#include "proc_events.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stat_parser.h"
+
+// Socket buffer asked for, bursts of forks (make -j) must not overflow it
+static constexpr int kReceiveBuffer{4 * 1024 * 1024};
+
+static bool sendGenl(int socket, std::uint16_t family, std::uint8_t command,
+                     std::uint16_t attribute, const void *data,
+                     std::size_t size);
+static const nlattr *findAttribute(const char *first, const char *last,
+                                   std::uint16_t type);
+
+/**
+ * @brief Stops the listening thread
+ */
+ProcEvents::~ProcEvents() {
+  if (thread_.joinable()) {
+    std::uint64_t one = 1;
+    if (write(wakeup_, &one, sizeof(one)) == sizeof(one)) {
+      thread_.join();
+    } else {
+      thread_.detach();
+    }
+  }
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+  if (taskstats_ >= 0) {
+    close(taskstats_);
+  }
+  if (wakeup_ >= 0) {
+    close(wakeup_);
+  }
+}
+
+/**
+ * @brief Subscribes to the proc connector and starts listening
+ * Needs CAP_NET_ADMIN and the initial pid namespace.
+ *
+ * @return {bool} : false if the connector is unavailable
+ */
+bool ProcEvents::Start() {
+  if (Active()) {
+    return true;
+  }
+  socket_ = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (socket_ < 0) {
+    return false;
+  }
+  /* FORCE ignores rmem_max when privileged, plain SO_RCVBUF otherwise */
+  if (setsockopt(socket_, SOL_SOCKET, SO_RCVBUFFORCE, &kReceiveBuffer,
+                 sizeof(kReceiveBuffer)) != 0) {
+    setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &kReceiveBuffer,
+               sizeof(kReceiveBuffer));
+  }
+
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = CN_IDX_PROC;
+  if (bind(socket_, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) != 0) {
+    close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  /* nlmsghdr | cn_msg | PROC_CN_MCAST_LISTEN */
+  alignas(nlmsghdr) char
+      message[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))]{};
+  nlmsghdr *header = reinterpret_cast<nlmsghdr *>(message);
+  header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+  header->nlmsg_type = NLMSG_DONE;
+  header->nlmsg_pid = getpid();
+  cn_msg *connector = static_cast<cn_msg *>(NLMSG_DATA(header));
+  connector->id.idx = CN_IDX_PROC;
+  connector->id.val = CN_VAL_PROC;
+  connector->len = sizeof(proc_cn_mcast_op);
+  proc_cn_mcast_op operation = PROC_CN_MCAST_LISTEN;
+  memcpy(connector->data, &operation, sizeof(operation));
+
+  wakeup_ = eventfd(0, EFD_CLOEXEC);
+  if (send(socket_, message, header->nlmsg_len, 0) < 0 || wakeup_ < 0) {
+    close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  /* Without taskstats exits reaped early stay incomplete */
+  StartTaskstats();
+  thread_ = std::thread(&ProcEvents::Run, this);
+  return true;
+}
+
+/**
+ * @brief Returns whether events are received
+ *
+ * @return {bool} : true once Start succeeded
+ */
+bool ProcEvents::Active() const { return thread_.joinable(); }
+
+/**
+ * @brief Copies the live pids in ascending order
+ *
+ * @param pids : Filled with the pids, cleared first
+ * @return {bool} : false if the set is not trustworthy (never reset or
+ * events lost), a full scan and Reset are then needed; events are
+ * logged from this call until Reset
+ */
+bool ProcEvents::Pids(std::vector<int> &pids) {
+  pids.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!synced_) {
+    scanning_ = true;
+    overflowed_ = false;
+    scanLog_.clear();
+    return false;
+  }
+  pids.assign(pids_.begin(), pids_.end());
+  return true;
+}
+
+/**
+ * @brief Replaces the set with the result of a full /proc scan, then
+ * applies the events logged since Pids asked for it
+ *
+ * @param pids : Pids listed by the scan
+ */
+void ProcEvents::Reset(const std::vector<int> &pids) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pids_.clear();
+  pids_.insert(pids.begin(), pids.end());
+  /* In order: an exit then a fork may reuse the pid */
+  for (const auto &[pid, added] : scanLog_) {
+    if (added) {
+      pids_.insert(pid);
+    } else {
+      pids_.erase(pid);
+    }
+  }
+  scanLog_.clear();
+  scanning_ = false;
+  /* Events lost during the scan: the next tick scans again */
+  synced_ = !overflowed_;
+}
+
+/**
+ * @brief Removes a pid found dead by a reader
+ *
+ * @param pid : Pid whose /proc entry is gone
+ */
+void ProcEvents::Forget(int pid) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Erase(pid);
+}
+
+/**
+ * @brief Moves the exits seen since the previous call
+ *
+ * @param exits : Receives the exit records, cleared first
+ * @return {uint64_t} : Number of exits dropped because more than
+ * kMaxExits happened since the previous call
+ */
+std::uint64_t ProcEvents::TakeExits(std::vector<ExitRecord_t> &exits) {
+  exits.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  exits.swap(exits_);
+  std::uint64_t dropped = dropped_;
+  dropped_ = 0;
+  return dropped;
+}
+
+/**
+ * @brief Body of the listening thread
+ */
+void ProcEvents::Run() {
+  alignas(nlmsghdr) char buffer[16 * 1024];
+  /* poll skips a negative fd, taskstats is optional */
+  pollfd fds[3]{{socket_, POLLIN, 0}, {wakeup_, POLLIN, 0},
+                {taskstats_, POLLIN, 0}};
+  while (true) {
+    if (poll(fds, 3, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[1].revents != 0) {
+      break;
+    }
+    /* Accounting is sent before the exit event, read it first */
+    DrainTaskstats();
+    /* Drain everything queued before polling again */
+    while (true) {
+      long size = recv(socket_, buffer, sizeof(buffer), MSG_DONTWAIT);
+      if (size > 0) {
+        Dispatch(buffer, size);
+      } else if (size < 0 && errno == ENOBUFS) {
+        /* Events were lost: the set is wrong until the next full scan */
+        std::lock_guard<std::mutex> lock(mutex_);
+        synced_ = false;
+        overflowed_ = true;
+      } else {
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Applies one datagram of events
+ */
+void ProcEvents::Dispatch(const char *buffer, long size) {
+  int remaining = size;
+  for (const nlmsghdr *header = reinterpret_cast<const nlmsghdr *>(buffer);
+       NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+    if (header->nlmsg_type == NLMSG_ERROR ||
+        header->nlmsg_type == NLMSG_NOOP) {
+      continue;
+    }
+    const cn_msg *connector = static_cast<const cn_msg *>(NLMSG_DATA(header));
+    if (connector->id.idx != CN_IDX_PROC || connector->id.val != CN_VAL_PROC ||
+        connector->len < sizeof(proc_event)) {
+      continue;
+    }
+    proc_event event;
+    memcpy(&event, connector->data, sizeof(event));
+
+    if (event.what == proc_event::PROC_EVENT_FORK) {
+      const auto &fork = event.event_data.fork;
+      if (fork.child_pid == fork.child_tgid) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Insert(fork.child_tgid);
+      }
+    } else if (event.what == proc_event::PROC_EVENT_EXIT) {
+      const auto &exit = event.event_data.exit;
+      if (exit.process_pid == exit.process_tgid) {
+        Exited(exit.process_tgid, exit.exit_code);
+      } else {
+        accounting_.erase(exit.process_pid);
+        /* The group of a leader gone first ends with its last thread */
+        if (leaderGone_.count(exit.process_tgid) != 0) {
+          Exited(exit.process_tgid, exit.exit_code);
+        }
+      }
+    }
+    /* exec keeps the pid, the scan sees the new comm */
+  }
+}
+
+/**
+ * @brief Records the exit of a process
+ * The event is sent after exit_notify() signalled the parent, which often
+ * reaps the process before its stat can be read. The taskstats record of
+ * the exit is used then: it is exact for a single threaded process but
+ * only counts the leader thread of a group.
+ * A leader may exit before its other threads (pthread_exit in main): its
+ * stat then still counts them and the process is kept until the exit of
+ * the last one. Taskstats are not used for such a group.
+ */
+void ProcEvents::Exited(int pid, std::uint32_t status) {
+  static const long clkTck = sysconf(_SC_CLK_TCK);
+  ExitRecord_t record;
+  record.pid = pid;
+  record.exitCode = WIFSIGNALED(status) ? -WTERMSIG(status)
+                                        : WEXITSTATUS(status);
+
+  using LinuxParser::Field;
+  using ExitParser =
+      LinuxParser::StatParser<Field::kComm, Field::kUtime, Field::kStime,
+                              Field::kNumThreads, Field::kStarttime>;
+  ExitParser::Record_t stat;
+  bool const read = ExitParser::Read(pid, stat);
+  /* A zombie leader is counted until the group is released */
+  if (read && stat.Get<Field::kNumThreads>() > 1) {
+    if (leaderGone_.size() >= kMaxExits) {
+      leaderGone_.clear();
+    }
+    leaderGone_.insert(pid);
+    return;
+  }
+  /* The taskstats of such a leader predate the rest of its group */
+  bool const outlived = leaderGone_.erase(pid) > 0;
+  if (clkTck > 0 && read) {
+    timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    float const now = boot.tv_sec + boot.tv_nsec / 1e9f;
+    memcpy(record.comm, stat.Get<Field::kComm>().data(), sizeof(record.comm));
+    record.cpuSeconds =
+        float(stat.Get<Field::kUtime>() + stat.Get<Field::kStime>()) / clkTck;
+    record.runtimeSeconds =
+        now - float(stat.Get<Field::kStarttime>()) / clkTck;
+    record.complete = true;
+  }
+  auto accounted = accounting_.find(pid);
+  if (outlived && accounted != accounting_.end()) {
+    accounting_.erase(accounted);
+    accounted = accounting_.end();
+  }
+  if (!record.complete && !outlived && accounted == accounting_.end()) {
+    /* Sent before the exit event but maybe not read yet */
+    DrainTaskstats();
+    accounted = accounting_.find(pid);
+  }
+  if (accounted != accounting_.end()) {
+    if (!record.complete) {
+      int const exitCode = record.exitCode;
+      record = accounted->second;
+      record.exitCode = exitCode;
+    }
+    accounting_.erase(accounted);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Erase(pid);
+  if (exits_.size() >= kMaxExits) {
+    exits_.erase(exits_.begin());
+    dropped_++;
+  }
+  exits_.push_back(record);
+}
+
+/**
+ * @brief Registers for the taskstats exit records of every CPU
+ *
+ * @return {bool} : false if taskstats is unavailable
+ */
+bool ProcEvents::StartTaskstats() {
+  taskstats_ = socket(PF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+  if (taskstats_ < 0) {
+    return false;
+  }
+  setsockopt(taskstats_, SOL_SOCKET, SO_RCVBUFFORCE, &kReceiveBuffer,
+             sizeof(kReceiveBuffer));
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+
+  /* Resolve the family id, then register for exits on every CPU */
+  alignas(nlmsghdr) char buffer[4096];
+  long size = -1;
+  if (bind(taskstats_, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) == 0 &&
+      sendGenl(taskstats_, GENL_ID_CTRL, CTRL_CMD_GETFAMILY,
+               CTRL_ATTR_FAMILY_NAME, TASKSTATS_GENL_NAME,
+               sizeof(TASKSTATS_GENL_NAME))) {
+    size = recv(taskstats_, buffer, sizeof(buffer), 0);
+  }
+  const nlmsghdr *header = reinterpret_cast<const nlmsghdr *>(buffer);
+  if (size >= long(NLMSG_LENGTH(GENL_HDRLEN)) && NLMSG_OK(header, size) &&
+      header->nlmsg_type == GENL_ID_CTRL) {
+    const char *first =
+        static_cast<const char *>(NLMSG_DATA(header)) + GENL_HDRLEN;
+    const nlattr *id = findAttribute(
+        first, reinterpret_cast<const char *>(header) + header->nlmsg_len,
+        CTRL_ATTR_FAMILY_ID);
+    if (id != nullptr && id->nla_len >= NLA_HDRLEN + sizeof(family_)) {
+      memcpy(&family_, reinterpret_cast<const char *>(id) + NLA_HDRLEN,
+             sizeof(family_));
+    }
+  }
+
+  char cpus[32];
+  snprintf(cpus, sizeof(cpus), "0-%ld", sysconf(_SC_NPROCESSORS_CONF) - 1);
+  if (family_ == 0 ||
+      !sendGenl(taskstats_, family_, TASKSTATS_CMD_GET,
+                TASKSTATS_CMD_ATTR_REGISTER_CPUMASK, cpus, strlen(cpus) + 1)) {
+    close(taskstats_);
+    taskstats_ = -1;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads the taskstats records queued on the socket
+ */
+void ProcEvents::DrainTaskstats() {
+  if (taskstats_ < 0) {
+    return;
+  }
+  alignas(nlmsghdr) char buffer[16 * 1024];
+  while (true) {
+    long size = recv(taskstats_, buffer, sizeof(buffer), MSG_DONTWAIT);
+    /* ENOBUFS lost records, those exits fall back to the stat read */
+    if (size > 0) {
+      Accounted(buffer, size);
+    } else if (size >= 0 || errno != ENOBUFS) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Keeps the accounting of one taskstats message until the exit
+ * event of its process
+ */
+void ProcEvents::Accounted(const char *buffer, long size) {
+  int remaining = size;
+  for (const nlmsghdr *header = reinterpret_cast<const nlmsghdr *>(buffer);
+       NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+    if (header->nlmsg_type != family_ ||
+        header->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) {
+      continue;
+    }
+    /* TASKSTATS_TYPE_AGGR_PID { TASKSTATS_TYPE_PID, TASKSTATS_TYPE_STATS } */
+    const char *first =
+        static_cast<const char *>(NLMSG_DATA(header)) + GENL_HDRLEN;
+    const char *last = reinterpret_cast<const char *>(header) +
+                       header->nlmsg_len;
+    const nlattr *aggregate =
+        findAttribute(first, last, TASKSTATS_TYPE_AGGR_PID);
+    if (aggregate == nullptr) {
+      continue;
+    }
+    const char *nested = reinterpret_cast<const char *>(aggregate);
+    const nlattr *attribute = findAttribute(
+        nested + NLA_HDRLEN, nested + aggregate->nla_len, TASKSTATS_TYPE_STATS);
+    if (attribute == nullptr) {
+      continue;
+    }
+    /* The kernel struct may be older or newer than the header */
+    taskstats stats{};
+    memcpy(&stats, reinterpret_cast<const char *>(attribute) + NLA_HDRLEN,
+           std::min<std::size_t>(attribute->nla_len - NLA_HDRLEN,
+                                 sizeof(stats)));
+    if (stats.version >= 13 && stats.ac_tgid != stats.ac_pid) {
+      continue;
+    }
+    /* Sent with the end of a multithreaded group: the stats only count
+       the leader, the last counters of the table are closer */
+    if (findAttribute(first, last, TASKSTATS_TYPE_AGGR_TGID) != nullptr) {
+      continue;
+    }
+
+    if (accounting_.size() >= kMaxExits) {
+      accounting_.clear();
+    }
+    ExitRecord_t &record = accounting_[int(stats.ac_pid)];
+    record.pid = int(stats.ac_pid);
+    memcpy(record.comm, stats.ac_comm, sizeof(record.comm) - 1);
+    record.comm[sizeof(record.comm) - 1] = '\0';
+    record.cpuSeconds = float(stats.ac_utime + stats.ac_stime) / 1e6f;
+    record.runtimeSeconds = float(stats.ac_etime) / 1e6f;
+    record.complete = true;
+  }
+}
+
+/**
+ * @brief Adds a pid to the set, logging it while a scan runs.
+ * mutex_ must be held.
+ */
+void ProcEvents::Insert(int pid) {
+  pids_.insert(pid);
+  if (scanning_) {
+    scanLog_.emplace_back(pid, true);
+  }
+}
+
+/**
+ * @brief Removes a pid from the set, logging it while a scan runs.
+ * mutex_ must be held.
+ */
+void ProcEvents::Erase(int pid) {
+  pids_.erase(pid);
+  if (scanning_) {
+    scanLog_.emplace_back(pid, false);
+  }
+}
+
+/**
+ * @brief Sends a generic netlink request holding a single attribute
+ *
+ * @param socket : NETLINK_GENERIC socket
+ * @param family : Family id
+ * @param command : Command of the family
+ * @param attribute : Attribute type
+ * @param data : Attribute payload
+ * @param size : Payload size, at most 64 bytes
+ * @return {bool} : true if the request was sent
+ */
+static bool sendGenl(int socket, std::uint16_t family, std::uint8_t command,
+                     std::uint16_t attribute, const void *data,
+                     std::size_t size) {
+  alignas(nlmsghdr) char
+      message[NLMSG_SPACE(GENL_HDRLEN + NLA_HDRLEN + 64)]{};
+  if (size > 64) {
+    return false;
+  }
+  nlmsghdr *header = reinterpret_cast<nlmsghdr *>(message);
+  header->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN + NLA_ALIGN(NLA_HDRLEN + size));
+  header->nlmsg_type = family;
+  header->nlmsg_flags = NLM_F_REQUEST;
+  genlmsghdr *genl = static_cast<genlmsghdr *>(NLMSG_DATA(header));
+  genl->cmd = command;
+  genl->version = 1;
+  nlattr *payload = reinterpret_cast<nlattr *>(
+      reinterpret_cast<char *>(genl) + GENL_HDRLEN);
+  payload->nla_type = attribute;
+  payload->nla_len = NLA_HDRLEN + size;
+  memcpy(reinterpret_cast<char *>(payload) + NLA_HDRLEN, data, size);
+
+  sockaddr_nl kernel{};
+  kernel.nl_family = AF_NETLINK;
+  return sendto(socket, message, header->nlmsg_len, 0,
+                reinterpret_cast<sockaddr *>(&kernel), sizeof(kernel)) >= 0;
+}
+
+/**
+ * @brief Returns the first netlink attribute of a type in [first, last)
+ *
+ * @param first : First attribute
+ * @param last : End of the attributes
+ * @param type : Attribute type wanted
+ * @return {const nlattr*} : Attribute, null if absent or truncated
+ */
+static const nlattr *findAttribute(const char *first, const char *last,
+                                   std::uint16_t type) {
+  while (last - first >= NLA_HDRLEN) {
+    const nlattr *attribute = reinterpret_cast<const nlattr *>(first);
+    if (attribute->nla_len < NLA_HDRLEN ||
+        attribute->nla_len > last - first) {
+      return nullptr;
+    }
+    if ((attribute->nla_type & NLA_TYPE_MASK) == type) {
+      return attribute;
+    }
+    first += NLA_ALIGN(attribute->nla_len);
+  }
+  return nullptr;
+}
@@ -0,0 +1,93 @@
+#include "proc_files.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "linux_parser.h"
+
+// Initial buffer size, /proc/stat of a large host takes a few pages
+static constexpr std::size_t kInitialBuffer{4096};
+
+/**
+ * @brief Returns the registry shared by the whole process
+ *
+ * @return {ProcFiles&} : The process-wide instance
+ */
+ProcFiles &ProcFiles::Instance() {
+  static ProcFiles instance;
+  return instance;
+}
+
+ProcFiles::~ProcFiles() { CloseAll(); }
+
+/**
+ * @brief Reads the whole file into buffer
+ * The buffer is sized once and only grows until the file fits, its
+ * size is not the length of the content: callers reuse it from one
+ * tick to the next and parse text.
+ *
+ * @param file : File to read
+ * @param buffer : Storage for the content of the file
+ * @param text : Content of the file, points into buffer
+ * @return {bool} : false if the file cannot be opened or read
+ */
+bool ProcFiles::Read(File file, std::string &buffer,
+                     std::string_view &text) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (directory_ != LinuxParser::ProcDirectory()) {
+    CloseAll();
+    directory_ = LinuxParser::ProcDirectory();
+  }
+
+  /* Sized once, a resize on every call would zero-fill the buffer */
+  if (buffer.size() < kInitialBuffer) {
+    buffer.resize(kInitialBuffer);
+  }
+  text = {};
+  /* One retry with a fresh descriptor if the read fails */
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (fds_[file] < 0 && !Open(file)) {
+      break;
+    }
+    ssize_t size = pread(fds_[file], &buffer[0], buffer.size(), 0);
+    if (size < 0) {
+      close(fds_[file]);
+      fds_[file] = -1;
+      continue;
+    }
+    /* proc fills the whole buffer when the file is larger: grow, retry */
+    if (size_t(size) == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+      attempt--;
+      continue;
+    }
+    text = std::string_view(buffer.data(), size);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Closes every descriptor
+ */
+void ProcFiles::CloseAll() {
+  for (int &fd : fds_) {
+    if (fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+}
+
+/**
+ * @brief Opens a file under directory_
+ *
+ * @return {bool} : false if it cannot be opened
+ */
+bool ProcFiles::Open(File file) {
+  static const char *const kNames[kFiles_]{"stat", "meminfo", "uptime"};
+  std::string path = directory_ + kNames[file];
+  fds_[file] = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  return fds_[file] >= 0;
+}
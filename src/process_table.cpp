@@ -0,0 +1,409 @@
+#include "process_table.h"
+
+#include <cstring>
+#include <unistd.h>
+
+#include "string_pool.h"
+
+using std::size_t;
+using std::string;
+
+long ProcessTable::clkTck_ = sysconf(_SC_CLK_TCK);
+long ProcessTable::pageKb_ = sysconf(_SC_PAGESIZE) / 1024;
+
+/**
+ * @brief Releases the interned strings held by the rows
+ */
+ProcessTable::~ProcessTable() {
+  for (size_t row = 0; row < Size(); row++) {
+    Retire(row);
+  }
+}
+
+/**
+ * @brief Construct a new ProcessTable object
+ *
+ * @param profiler : Times the status and user reads, must outlive the
+ * table
+ */
+ProcessTable::ProcessTable(TickProfiler &profiler) : profiler_(profiler) {}
+
+/**
+ * @brief Starts a refresh, followed by Add or Keep for every live pid
+ * and End
+ *
+ * @param elapsed : Seconds elapsed since the previous refresh
+ * @param uptime : System uptime in seconds, used for new processes
+ */
+void ProcessTable::Begin(float elapsed, long uptime) {
+  next_.Clear();
+  next_.Reserve(Size());
+  cursor_ = 0;
+  elapsed_ = elapsed;
+  uptime_ = uptime;
+}
+
+/**
+ * @brief Adds the stat of a live process to the refresh
+ * If the starttime changed the pid was reused by a new process and the
+ * row starts over as a new one. The cached command and user are dropped
+ * when comm changes (exec) or every kRecheckSeconds.
+ *
+ * @param pid : Process ID, greater than the pid of the previous Add
+ * @param stat : /proc/pid/stat of the process
+ * @param io : /proc/pid/io of the process, null if it was not read
+ */
+void ProcessTable::Add(int pid, const Stat_t &stat,
+                       const LinuxParser::ProcIo_t *io) {
+  size_t const row = Carry(pid, true);
+
+  if (clkTck_ <= 0) {
+    return;
+  }
+  using LinuxParser::Field;
+  long total_time = stat.Get<Field::kUtime>() + stat.Get<Field::kStime>();
+  /* Kept rows were not read for a few ticks, the delta spans them all */
+  float seconds = next_.statAge[row] + elapsed_;
+  long delta = total_time - next_.ticks[row];
+  next_.statAge[row] = 0;
+
+  /* New process (or pid reused): average over its whole life */
+  unsigned long long const starttime = stat.Get<Field::kStarttime>();
+  if (starttime != next_.startTime[row]) {
+    seconds = uptime_ - ((float)starttime / clkTck_);
+    delta = total_time;
+    next_.startTime[row] = starttime;
+    next_.pss[row] = -1;
+    next_.uss[row] = -1;
+    next_.memoryAt[row] = {};
+    next_.ioState[row] = kIoUnknown;
+    InvalidateCache(row);
+  }
+
+  /* A failed io read keeps its counters, the next delta spans both */
+  float const ioSeconds = next_.ioAge[row] + elapsed_;
+  if (io != nullptr) {
+    UpdateIo(row, *io, ioSeconds);
+    next_.ioAge[row] = 0;
+  } else {
+    next_.ioAge[row] = ioSeconds;
+  }
+
+  /* A new comm means the process called exec */
+  next_.cacheAge[row] += elapsed_;
+  const Comm_t &comm = stat.Get<Field::kComm>();
+  if (strncmp(next_.comm[row].data(), comm.data(), sizeof(Comm_t)) != 0 ||
+      next_.cacheAge[row] > kRecheckSeconds) {
+    InvalidateCache(row);
+  }
+
+  /* Used CPU, changed state or runnable/uninterruptible: active */
+  char const state = stat.Get<Field::kState>();
+  bool const active = delta > 0 || state != next_.state[row] ||
+                      state == 'R' || state == 'D';
+  next_.idleTicks[row] = active ? 0 : next_.idleTicks[row] + 1;
+
+  next_.comm[row] = comm;
+  next_.cpu[row] = seconds > 0 ? ((float)delta / clkTck_) / seconds : 0.0f;
+  next_.ticks[row] = total_time;
+  next_.rss[row] = stat.Get<Field::kRss>();
+  next_.state[row] = state;
+  next_.threads[row] = stat.Get<Field::kNumThreads>();
+}
+
+/**
+ * @brief Carries a live process whose stat was not read this tick, its
+ * counters and CPU utilization are those of its last read
+ *
+ * @param pid : Process ID, greater than the pid of the previous Add
+ */
+void ProcessTable::Keep(int pid) {
+  size_t const row = Carry(pid, false);
+  if (row == kNoRow) {
+    return;
+  }
+  next_.statAge[row] += elapsed_;
+  next_.ioAge[row] += elapsed_;
+  next_.cacheAge[row] += elapsed_;
+  next_.idleTicks[row]++;
+}
+
+/**
+ * @brief Ends a refresh, pids neither added nor kept are retired
+ */
+void ProcessTable::End() {
+  while (cursor_ < Size()) {
+    Retire(cursor_++);
+  }
+  std::swap(current_, next_);
+}
+
+/**
+ * @brief Returns the row of a pid, by binary search
+ *
+ * @param pid : Process ID
+ * @return {size_t} : Row of the pid, kNoRow if unknown
+ */
+size_t ProcessTable::Find(int pid) const {
+  size_t row = LowerBound(pid);
+  if (row == Size() || current_.pid[row] != pid) {
+    return kNoRow;
+  }
+  return row;
+}
+
+/**
+ * @brief Returns the first row whose pid is not lower than pid
+ *
+ * @param pid : Process ID
+ * @return {size_t} : Row, Size() if every pid is lower
+ */
+size_t ProcessTable::LowerBound(int pid) const {
+  return std::lower_bound(current_.pid.begin(), current_.pid.end(), pid) -
+         current_.pid.begin();
+}
+
+/**
+ * @brief User + system time over the whole life, in seconds
+ */
+float ProcessTable::CpuTime(size_t row) const {
+  return clkTck_ > 0 ? (float)current_.ticks[row] / clkTck_ : 0.0f;
+}
+
+/**
+ * @brief Resident set size in kB, from the rss field of stat
+ */
+long ProcessTable::Rss(size_t row) const {
+  return current_.rss[row] * pageKb_;
+}
+
+/**
+ * @brief Start time of the process in seconds after boot
+ */
+long ProcessTable::UpTime(size_t row) const {
+  return clkTck_ > 0 ? current_.startTime[row] / clkTck_ : 0;
+}
+
+/**
+ * @brief Returns the user owning the process
+ * The uid is read from /proc/pid/status on first use and the name is
+ * kept in the StringPool.
+ *
+ * @param row : Row of the process
+ * @return {string} : User name
+ */
+string ProcessTable::User(size_t row) {
+  StringPool &pool = StringPool::Instance();
+  if (current_.user[row] == StringPool::kNone) {
+    string uid;
+    {
+      TickProfiler::Timer timer(profiler_, TickStage::kStatus);
+      uid = LinuxParser::Uid(std::to_string(current_.pid[row]));
+    }
+    TickProfiler::Timer timer(profiler_, TickStage::kUser);
+    string user = LinuxParser::User(uid);
+    current_.user[row] = pool.Intern(user);
+    /* Pool full: serve this one uncached */
+    if (current_.user[row] == StringPool::kNone) {
+      return user;
+    }
+  }
+  return pool.Get(current_.user[row]);
+}
+
+/**
+ * @brief Returns the command line of the process
+ * Read from /proc/pid/cmdline on first use and kept in the StringPool.
+ *
+ * @param row : Row of the process
+ * @return {string} : Command line
+ */
+string ProcessTable::Command(size_t row) {
+  StringPool &pool = StringPool::Instance();
+  if (current_.command[row] == StringPool::kNone) {
+    string command = LinuxParser::Command(std::to_string(current_.pid[row]));
+    current_.command[row] = pool.Intern(command);
+    /* Pool full: serve this one uncached */
+    if (current_.command[row] == StringPool::kNone) {
+      return command;
+    }
+  }
+  return pool.Get(current_.command[row]);
+}
+
+/**
+ * @brief Stores the result of a smaps_rollup read
+ *
+ * @param row : Row of the process
+ * @param pss : Proportional set size in kB, -1 if the read failed
+ * @param uss : Unique set size in kB, -1 if the read failed
+ * @param at : Time of the read
+ */
+void ProcessTable::SetMemory(size_t row, long pss, long uss,
+                             std::chrono::steady_clock::time_point at) {
+  current_.pss[row] = pss;
+  current_.uss[row] = uss;
+  current_.memoryAt[row] = at;
+}
+
+/**
+ * @brief Moves the row of pid from current_ to next_, retiring the rows
+ * of the pids skipped since the previous call
+ *
+ * @param pid : Process ID, greater than the pid of the previous call
+ * @param create : Create an empty row when pid is unknown
+ * @return {size_t} : Row in next_, kNoRow if pid is unknown and create
+ * is false
+ */
+size_t ProcessTable::Carry(int pid, bool create) {
+  /* Rows before pid in the old table were not listed anymore */
+  while (cursor_ < Size() && current_.pid[cursor_] < pid) {
+    Retire(cursor_++);
+  }
+
+  size_t const row = next_.pid.size();
+  if (cursor_ < Size() && current_.pid[cursor_] == pid) {
+    /* Known pid: carry its state, Add detects pid reuse */
+    next_.pid.push_back(pid);
+    next_.startTime.push_back(current_.startTime[cursor_]);
+    next_.ticks.push_back(current_.ticks[cursor_]);
+    next_.cpu.push_back(current_.cpu[cursor_]);
+    next_.rss.push_back(current_.rss[cursor_]);
+    next_.state.push_back(current_.state[cursor_]);
+    next_.threads.push_back(current_.threads[cursor_]);
+    next_.comm.push_back(current_.comm[cursor_]);
+    next_.statAge.push_back(current_.statAge[cursor_]);
+    next_.idleTicks.push_back(current_.idleTicks[cursor_]);
+    next_.cacheAge.push_back(current_.cacheAge[cursor_]);
+    next_.user.push_back(current_.user[cursor_]);
+    next_.command.push_back(current_.command[cursor_]);
+    next_.io.push_back(current_.io[cursor_]);
+    next_.ioRate.push_back(current_.ioRate[cursor_]);
+    next_.ioState.push_back(current_.ioState[cursor_]);
+    next_.ioAge.push_back(current_.ioAge[cursor_]);
+    next_.pss.push_back(current_.pss[cursor_]);
+    next_.uss.push_back(current_.uss[cursor_]);
+    next_.memoryAt.push_back(current_.memoryAt[cursor_]);
+    cursor_++;
+  } else if (create) {
+    /* starttime 0 is valid (early boot), use an impossible one */
+    next_.pid.push_back(pid);
+    next_.startTime.push_back(~0ull);
+    next_.ticks.push_back(0);
+    next_.cpu.push_back(0);
+    next_.rss.push_back(0);
+    next_.state.push_back(' ');
+    next_.threads.push_back(0);
+    next_.comm.push_back(Comm_t{});
+    next_.statAge.push_back(0);
+    next_.idleTicks.push_back(0);
+    next_.cacheAge.push_back(0);
+    next_.user.push_back(StringPool::kNone);
+    next_.command.push_back(StringPool::kNone);
+    next_.io.emplace_back();
+    next_.ioRate.emplace_back();
+    next_.ioState.push_back(kIoUnknown);
+    next_.ioAge.push_back(0);
+    next_.pss.push_back(-1);
+    next_.uss.push_back(-1);
+    next_.memoryAt.emplace_back();
+  } else {
+    return kNoRow;
+  }
+  return row;
+}
+
+/**
+ * @brief Turns a read of /proc/pid/io into rates for a row of next_
+ * The first read of a process covers its whole life, like its CPU.
+ *
+ * @param row : Row in next_
+ * @param io : Counters just read
+ * @param seconds : Interval since the previous io read of the row
+ */
+void ProcessTable::UpdateIo(size_t row, const LinuxParser::ProcIo_t &io,
+                            float seconds) {
+  LinuxParser::ProcIo_t previous{};
+  if (next_.ioState[row] == kIoKnown) {
+    previous = next_.io[row];
+  } else {
+    seconds = uptime_ - ((float)next_.startTime[row] / clkTck_);
+  }
+  /* Counters only grow, a smaller one means the read raced an exit */
+  auto rate = [seconds](unsigned long long now, unsigned long long before) {
+    return seconds > 0 && now > before ? float(now - before) / seconds
+                                       : 0.0f;
+  };
+  IoRates_t &rates = next_.ioRate[row];
+  rates.readBytes = rate(io.readBytes, previous.readBytes);
+  rates.writeBytes = rate(io.writeBytes, previous.writeBytes);
+  rates.syscr = rate(io.syscr, previous.syscr);
+  rates.syscw = rate(io.syscw, previous.syscw);
+  next_.io[row] = io;
+  next_.ioState[row] = kIoKnown;
+}
+
+/**
+ * @brief Drops the interned strings of a row of current_
+ */
+void ProcessTable::Retire(size_t row) {
+  StringPool::Instance().Release(current_.user[row]);
+  StringPool::Instance().Release(current_.command[row]);
+}
+
+/**
+ * @brief Drops the cached command and user of a row of next_
+ */
+void ProcessTable::InvalidateCache(size_t row) {
+  StringPool::Instance().Release(next_.user[row]);
+  StringPool::Instance().Release(next_.command[row]);
+  next_.user[row] = StringPool::kNone;
+  next_.command[row] = StringPool::kNone;
+  next_.cacheAge[row] = 0;
+}
+
+void ProcessTable::Columns_t::Clear() {
+  pid.clear();
+  startTime.clear();
+  ticks.clear();
+  cpu.clear();
+  rss.clear();
+  state.clear();
+  threads.clear();
+  comm.clear();
+  statAge.clear();
+  idleTicks.clear();
+  cacheAge.clear();
+  user.clear();
+  command.clear();
+  io.clear();
+  ioRate.clear();
+  ioState.clear();
+  ioAge.clear();
+  pss.clear();
+  uss.clear();
+  memoryAt.clear();
+}
+
+void ProcessTable::Columns_t::Reserve(size_t size) {
+  pid.reserve(size);
+  startTime.reserve(size);
+  ticks.reserve(size);
+  cpu.reserve(size);
+  rss.reserve(size);
+  state.reserve(size);
+  threads.reserve(size);
+  comm.reserve(size);
+  statAge.reserve(size);
+  idleTicks.reserve(size);
+  cacheAge.reserve(size);
+  user.reserve(size);
+  command.reserve(size);
+  io.reserve(size);
+  ioRate.reserve(size);
+  ioState.reserve(size);
+  ioAge.reserve(size);
+  pss.reserve(size);
+  uss.reserve(size);
+  memoryAt.reserve(size);
+}
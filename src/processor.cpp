@@ -1,15 +1,84 @@
 #include "processor.h"
 #include "linux_parser.h"
 
+using LinuxParser::CpuTimes_t;
+
+/**
+ * @brief Computes the CPU time split between two samples of the same CPU
+ *
+ * @param prev : Counters at the start of the interval
+ * @param curr : Counters at the end of the interval
+ * @return {CpuLoad_t} : Fractions of the elapsed jiffies
+ */
+static CpuLoad_t computeLoad(const CpuTimes_t &prev, const CpuTimes_t &curr);
+
 /**
- * @brief Returns the CPU utilization
+ * @brief Returns the CPU utilization over the last sampling interval
  *
  * @return {float} : CPU utilization in fraction
  */
-float Processor::Utilization() {
-  long total = LinuxParser::Jiffies();
-  long active = LinuxParser::ActiveJiffies();
+float Processor::Utilization() { return load_.total; }
+
+/**
+ * @brief Returns the aggregate CPU time split over the last interval
+ *
+ * @return {const CpuLoad_t&} : Load of all the CPUs together
+ */
+const CpuLoad_t &Processor::Load() const { return load_; }
+
+/**
+ * @brief Returns the CPU time split of every logical core (cpu0..cpuN)
+ * over the last interval
+ *
+ * @return {const std::vector<CpuLoad_t>&} : One entry per core
+ */
+const std::vector<CpuLoad_t> &Processor::Cores() const { return cores_; }
+
+/**
+ * @brief Computes the load over the interval elapsed since the previous
+ * snapshot then keeps the new snapshot for the next call.
+ * On the first call the interval starts at boot.
+ *
+ * @param snapshot : Snapshot read by System for this tick
+ */
+void Processor::Update(const LinuxParser::StatSnapshot_t &snapshot) {
+  load_ = computeLoad(prev_, snapshot.cpu);
+  prev_ = snapshot.cpu;
+
+  /* Cores may be hot(un)plugged: an offline core reads as zero jiffies
+     and no load, a core coming (back) online starts its interval at boot */
+  size_t nbCores = snapshot.cores.size();
+  prevCores_.resize(nbCores);
+  cores_.resize(nbCores);
+  for (size_t i = 0; i < nbCores; i++) {
+    cores_[i] = computeLoad(prevCores_[i], snapshot.cores[i]);
+    prevCores_[i] = snapshot.cores[i];
+  }
+}
+
+static CpuLoad_t computeLoad(const CpuTimes_t &prev, const CpuTimes_t &curr) {
+  using namespace LinuxParser;
+  CpuLoad_t load;
+  long delta[kGuestNice_ + 1];
+
+  /* Counters going backwards (offlined core) are treated as no activity */
+  for (int state = kUser_; state <= kGuestNice_; state++) {
+    long diff = curr.values[state] - prev.values[state];
+    delta[state] = diff > 0 ? diff : 0;
+  }
+
+  long active = delta[kUser_] + delta[kNice_] + delta[kSystem_] +
+                delta[kIRQ_] + delta[kSoftIRQ_] + delta[kSteal_];
+  long total = active + delta[kIdle_] + delta[kIOwait_];
+
+  if (total > 0) {
+    float elapsed = (float)total;
+    load.user = (delta[kUser_] + delta[kNice_]) / elapsed;
+    load.system = (delta[kSystem_] + delta[kIRQ_] + delta[kSoftIRQ_]) / elapsed;
+    load.iowait = delta[kIOwait_] / elapsed;
+    load.steal = delta[kSteal_] / elapsed;
+    load.total = active / elapsed;
+  }
 
-  float ret = (float)active / (float)total;
-  return ret;
-}
\ No newline at end of file
+  return load;
+}
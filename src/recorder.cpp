@@ -0,0 +1,240 @@
+#include "recorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace Recording;
+
+/**
+ * @brief Copies a string into a fixed size field, truncating it and
+ * keeping it NUL terminated
+ *
+ * @param field : Destination field
+ * @param text : Text to copy
+ */
+template <std::size_t N>
+static void copyText(char (&field)[N], const std::string &text) {
+  std::size_t length = std::min(text.size(), N - 1);
+  memcpy(field, text.data(), length);
+  field[length] = '\0';
+}
+
+/**
+ * @brief Copies a command line into a fixed size field like copyText,
+ * the NUL separators of its arguments become spaces
+ *
+ * @param field : Destination field
+ * @param command : Command line as read from /proc/pid/cmdline
+ */
+template <std::size_t N>
+static void copyCommand(char (&field)[N], const std::string &command) {
+  copyText(field, command);
+  std::replace(field, field + std::min(command.size(), N - 1), '\0', ' ');
+}
+
+/**
+ * @brief Closes the recording
+ */
+Recorder::~Recorder() { Close(); }
+
+/**
+ * @brief Creates the recording, an existing file is replaced
+ *
+ * @param path : Path of the recording
+ * @return {bool} : false if the file could not be created or mapped
+ */
+bool Recorder::Open(const std::string &path) {
+  Close();
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+
+  std::uint64_t dataOffset =
+      kHeaderSize + kIndexCapacity * sizeof(IndexEntry_t);
+  dataOffset_ = dataOffset;
+  if (!Reserve(dataOffset) || !Allocate(0, kHeaderSize)) {
+    Close();
+    return false;
+  }
+
+  Header_t header{};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.indexOffset = kHeaderSize;
+  header.indexCapacity = kIndexCapacity;
+  header.dataOffset = dataOffset;
+  header.dataEnd = dataOffset;
+  header.tickCount = 0;
+  struct timespec monotonic, realtime;
+  clock_gettime(CLOCK_MONOTONIC, &monotonic);
+  clock_gettime(CLOCK_REALTIME, &realtime);
+  header.wallClockOffsetNs =
+      (realtime.tv_sec - monotonic.tv_sec) * 1000000000ll +
+      (realtime.tv_nsec - monotonic.tv_nsec);
+  memcpy(map_, &header, sizeof(header));
+
+  return true;
+}
+
+/**
+ * @brief Appends one tick to the recording
+ *
+ * @param snapshot : Tick to append
+ * @return {bool} : false if the recording is not open, is full or
+ * could not be grown
+ */
+bool Recorder::Append(const Snapshot_t &snapshot) {
+  if (map_ == nullptr || Header()->tickCount >= Header()->indexCapacity) {
+    return false;
+  }
+
+  std::uint64_t coreCount = snapshot.cores.size();
+  std::uint64_t processCount = snapshot.processes.size();
+  std::uint64_t size = TickSize(coreCount, processCount);
+  if (!Reserve(Header()->dataEnd + size)) {
+    return false;
+  }
+  /* The mapping may have moved */
+  Header_t *header = Header();
+  if (header->tickCount == 0) {
+    copyText(header->operatingSystem, snapshot.operatingSystem);
+    copyText(header->kernel, snapshot.kernel);
+  }
+
+  char *at = map_ + header->dataEnd;
+  TickRecord_t tick{};
+  tick.tick = snapshot.tick;
+  tick.timeNs = snapshot.sampledAtNs;
+  tick.jitterNs = snapshot.jitterNs;
+  tick.cpu = snapshot.cpu;
+  tick.memory = snapshot.memory;
+  tick.totalProcesses = snapshot.totalProcesses;
+  tick.runningProcesses = snapshot.runningProcesses;
+  tick.uptime = snapshot.uptime;
+  tick.coreCount = coreCount;
+  tick.processCount = processCount;
+  memcpy(at, &tick, sizeof(tick));
+  memcpy(at + sizeof(tick), snapshot.cores.data(),
+         coreCount * sizeof(CpuLoad_t));
+
+  char *rows = at + (size - processCount * sizeof(ProcessRecord_t));
+  for (const ProcessRow_t &row : snapshot.processes) {
+    ProcessRecord_t record{};
+    record.pid = row.pid;
+    record.cpu = row.cpu;
+    record.ramMb = row.ramKb >= 0 ? row.ramKb / 1024 : -1;
+    record.uptime = row.uptime;
+    copyText(record.user, row.user);
+    copyCommand(record.command, row.command);
+    memcpy(rows, &record, sizeof(record));
+    rows += sizeof(record);
+  }
+
+  IndexEntry_t entry{snapshot.sampledAtNs, header->dataEnd};
+  std::uint64_t entryOffset =
+      header->indexOffset + header->tickCount * sizeof(entry);
+  /* The index stays a hole until its blocks are needed */
+  if (entryOffset % kIndexBlock == 0 && !Allocate(entryOffset, kIndexBlock)) {
+    return false;
+  }
+  memcpy(map_ + entryOffset, &entry, sizeof(entry));
+
+  /* Commit: data and index entry first, then the counters */
+  std::atomic_thread_fence(std::memory_order_release);
+  header->dataEnd += size;
+  header->tickCount++;
+
+  return true;
+}
+
+/**
+ * @brief Returns whether the index holds as many ticks as it can
+ *
+ * @return {bool} : true if Append fails for lack of index entries
+ */
+bool Recorder::Full() const {
+  return map_ != nullptr && Header()->tickCount >= Header()->indexCapacity;
+}
+
+/**
+ * @brief Trims the unused tail of the file, unmaps and closes it
+ */
+void Recorder::Close() {
+  if (map_ != nullptr) {
+    std::uint64_t dataEnd = Header()->dataEnd;
+    munmap(map_, mapSize_);
+    map_ = nullptr;
+    mapSize_ = 0;
+    if (ftruncate(fd_, dataEnd) != 0) {
+      /* Keep the slack, readers only trust Header_t::dataEnd */
+    }
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+/**
+ * @brief Grows the file and the mapping to hold at least size bytes,
+ * the blocks of the data area are allocated, the index is left sparse
+ *
+ * @param size : Bytes needed from the start of the file
+ * @return {bool} : false if the file could not be grown or its blocks
+ * allocated (disk full)
+ */
+bool Recorder::Reserve(std::uint64_t size) {
+  if (size <= mapSize_) {
+    return true;
+  }
+  std::uint64_t newSize = (size + kGrowStep - 1) / kGrowStep * kGrowStep;
+  if (ftruncate(fd_, newSize) != 0) {
+    return false;
+  }
+  std::uint64_t from = std::max(mapSize_, dataOffset_);
+  if (!Allocate(from, newSize - from)) {
+    return false;
+  }
+
+  void *map = map_ == nullptr
+                  ? mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         fd_, 0)
+                  : mremap(map_, mapSize_, newSize, MREMAP_MAYMOVE);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  map_ = static_cast<char *>(map);
+  mapSize_ = newSize;
+  return true;
+}
+
+/**
+ * @brief Allocates the blocks of a range of the file before it is written
+ * through the mapping: a hole written once the disk is full raises
+ * SIGBUS instead of failing here
+ *
+ * @param offset : Start of the range
+ * @param length : Length of the range
+ * @return {bool} : false if the blocks could not be allocated, errno
+ * is set
+ */
+bool Recorder::Allocate(std::uint64_t offset, std::uint64_t length) {
+  int const error = posix_fallocate(fd_, offset, length);
+  if (error != 0) {
+    /* Returned, not set in errno */
+    errno = error;
+    return false;
+  }
+  return true;
+}
+
+Recording::Header_t *Recorder::Header() const {
+  return reinterpret_cast<Header_t *>(map_);
+}
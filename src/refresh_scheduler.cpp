@@ -0,0 +1,79 @@
+#include "refresh_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+using std::size_t;
+using std::vector;
+
+/**
+ * @brief Returns the tier of a row of the table
+ *
+ * @param table : Process table
+ * @param row : Row of the process
+ * @return {Tier} : Tier from the idle ticks of the row
+ */
+RefreshScheduler::Tier RefreshScheduler::Classify(const ProcessTable &table,
+                                                  size_t row) {
+  unsigned const idle = table.IdleTicks(row);
+  if (idle == 0) {
+    return kHot;
+  }
+  return idle < kColdTicks ? kWarm : kCold;
+}
+
+/**
+ * @brief Plans the reads of one tick
+ *
+ * @param table : Process table of the previous tick
+ * @param pids : Live pids of this tick, ascending
+ * @param procsRunning : procs_running of /proc/stat for this tick
+ * @param self : Pid of the monitor when procsRunning was sampled by
+ * one of its threads, 0 otherwise (fixture)
+ * @param due : Receives, for each pid, whether its stat must be read
+ * @return {bool} : true if every pid is due (activity unaccounted for)
+ */
+bool RefreshScheduler::Plan(const ProcessTable &table,
+                            const vector<int> &pids, int procsRunning,
+                            int self, vector<unsigned char> &due) {
+  std::uint64_t const tick = tick_++;
+  std::fill(counts_, counts_ + kTiers, 0);
+  due.assign(pids.size(), 1);
+
+  /* procs_running counts threads: a process using n CPUs holds about n
+     runnable threads, even when its leader sleeps */
+  long runnable = 0;
+  for (size_t row = 0; row < table.Size(); row++) {
+    if (table.Pid(row) == self) {
+      continue;
+    }
+    long threads = std::lround(table.CpuUtilization(row));
+    if (table.State(row) == 'R') {
+      threads = std::max(threads, 1l);
+    }
+    runnable += std::min(threads, std::max(table.Threads(row), 1l));
+  }
+  /* The thread that read /proc/stat was running */
+  if (self != 0) {
+    procsRunning--;
+  }
+  bool const full = procsRunning > runnable;
+
+  /* Both lists are ascending, walk them together */
+  size_t row = 0;
+  for (size_t i = 0; i < pids.size(); i++) {
+    while (row < table.Size() && table.Pid(row) < pids[i]) {
+      row++;
+    }
+    if (row == table.Size() || table.Pid(row) != pids[i]) {
+      counts_[kHot]++;
+      continue;
+    }
+    Tier const tier = Classify(table, row);
+    counts_[tier]++;
+    if (!full) {
+      due[i] = (tick + unsigned(pids[i])) % kPeriods[tier] == 0;
+    }
+  }
+  return full;
+}
@@ -0,0 +1,123 @@
+#include "scan_pool.h"
+
+#include <algorithm>
+
+/**
+ * @brief Construct a new ScanPool object
+ * The calling thread takes part in the work, so workers - 1 threads
+ * are started.
+ *
+ * @param workers : Number of workers, at least 1
+ */
+ScanPool::ScanPool(unsigned workers) : slices_(std::max(workers, 1u)) {
+  for (unsigned worker = 1; worker < slices_.size(); worker++) {
+    threads_.emplace_back(&ScanPool::Run, this, worker);
+  }
+}
+
+/**
+ * @brief Stops and joins the worker threads
+ */
+ScanPool::~ScanPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Returns the number of workers, calling thread included
+ *
+ * @return {unsigned} : Number of workers
+ */
+unsigned ScanPool::Workers() const { return slices_.size(); }
+
+/**
+ * @brief Runs task(worker, index) for every index of [0, count) and
+ * returns once all of them are done.
+ *
+ * @param count : Number of indexes
+ * @param task : Work for one index
+ */
+void ScanPool::ParallelFor(
+    std::size_t count,
+    const std::function<void(unsigned, std::size_t)> &task) {
+  /* Contiguous slices keep neighbouring pids on the same worker */
+  std::size_t workers = slices_.size();
+  for (std::size_t worker = 0; worker < workers; worker++) {
+    slices_[worker].next.store(count * worker / workers,
+                               std::memory_order_relaxed);
+    slices_[worker].end = count * (worker + 1) / workers;
+  }
+
+  if (threads_.empty()) {
+    task_ = &task;
+    Work(0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    pending_ = threads_.size();
+    generation_++;
+  }
+  start_.notify_all();
+
+  Work(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+/**
+ * @brief Body of the background workers
+ *
+ * @param worker : Worker number
+ */
+void ScanPool::Run(unsigned worker) {
+  std::size_t seen = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+    if (stopping_) {
+      return;
+    }
+    seen = generation_;
+    lock.unlock();
+
+    Work(worker);
+
+    lock.lock();
+    if (--pending_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+/**
+ * @brief Claims and runs chunks, own slice first then the others
+ *
+ * @param worker : Worker number
+ */
+void ScanPool::Work(unsigned worker) {
+  std::size_t workers = slices_.size();
+  for (std::size_t offset = 0; offset < workers; offset++) {
+    Slice_t &slice = slices_[(worker + offset) % workers];
+    while (true) {
+      std::size_t first =
+          slice.next.fetch_add(kChunk, std::memory_order_relaxed);
+      if (first >= slice.end) {
+        break;
+      }
+      std::size_t last = std::min(first + kChunk, slice.end);
+      for (std::size_t index = first; index < last; index++) {
+        (*task_)(worker, index);
+      }
+    }
+  }
+}
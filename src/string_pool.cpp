@@ -0,0 +1,93 @@
+#include "string_pool.h"
+
+/**
+ * @brief Returns the pool shared by the whole process
+ *
+ * @return {StringPool&} : The process-wide instance
+ */
+StringPool &StringPool::Instance() {
+  static StringPool instance;
+  return instance;
+}
+
+/**
+ * @brief Returns the id of the text, adding it to the pool if needed.
+ * The caller owns one reference on the returned id.
+ *
+ * @param text : Text to intern, truncated to kMaxLength
+ * @return {uint32_t} : Id of the text, kNone if the pool is full
+ */
+std::uint32_t StringPool::Intern(std::string_view text) {
+  text = text.substr(0, kMaxLength);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto found = index_.find(text);
+  if (found != index_.end()) {
+    entries_[found->second].refs++;
+    return found->second;
+  }
+
+  std::string copy(text);
+  std::size_t cost = Cost(copy);
+  if (bytes_ + cost > kMaxBytes) {
+    return kNone;
+  }
+
+  std::uint32_t id;
+  if (!free_.empty()) {
+    id = free_.back();
+    free_.pop_back();
+  } else {
+    id = entries_.size();
+    entries_.emplace_back();
+  }
+  Entry_t &entry = entries_[id];
+  entry.text = std::move(copy);
+  entry.refs = 1;
+  index_.emplace(entry.text, id);
+  bytes_ += cost;
+
+  return id;
+}
+
+/**
+ * @brief Drops a reference on an id, the text is freed with the last one
+ *
+ * @param id : Id returned by Intern, kNone is ignored
+ */
+void StringPool::Release(std::uint32_t id) {
+  if (id == kNone) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry_t &entry = entries_[id];
+  if (--entry.refs == 0) {
+    index_.erase(entry.text);
+    bytes_ -= Cost(entry.text);
+    std::string().swap(entry.text);
+    free_.push_back(id);
+  }
+}
+
+/**
+ * @brief Returns the text of an id
+ * The reference stays valid as long as the caller holds the id.
+ *
+ * @param id : Id returned by Intern
+ * @return {const std::string&} : The interned text
+ */
+const std::string &StringPool::Get(std::uint32_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_[id].text;
+}
+
+/**
+ * @brief Bytes accounted for one entry: its text plus the entry and
+ * index bookkeeping
+ *
+ * @param text : Text of the entry
+ * @return {size_t} : Cost of the entry in bytes
+ */
+std::size_t StringPool::Cost(const std::string &text) {
+  return text.capacity() + sizeof(Entry_t) + 4 * sizeof(void *);
+}
@@ -1,16 +1,17 @@
+#include <cerrno>
+#include <chrono>
 #include <cstddef>
-#include <set>
+#include <cstring>
 #include <string>
 #include <unistd.h>
 #include <vector>
 
 #include "linux_parser.h"
-#include "process.h"
+#include "process_table.h"
 #include "processor.h"
 #include "system.h"
 #include <iostream>
 
-using std::set;
 using std::size_t;
 using std::string;
 using std::vector;
@@ -23,41 +24,227 @@ using std::vector;
 Processor &System::Cpu() { return cpu_; }
 
 /**
- * @brief reutrns the system's processes ordered by CPU utilization
+ * @brief Refreshes and returns the system's processes
+ * The table lives across ticks: survivors only have their counters
+ * refreshed, new pids are inserted and dead ones are retired.
  * 
- * @return vector<Process>& 
+ * @return ProcessTable& 
  */
-vector<Process> &System::Processes() {
-  // Clear and rebuild process list
-  processes_.clear();
+ProcessTable &System::Processes() {
+  /* Interval elapsed since the previous tick, on a monotonic clock */
+  auto now = std::chrono::steady_clock::now();
+  float elapsed = std::chrono::duration<float>(now - lastTick_).count();
+  lastTick_ = now;
+  long uptime = LinuxParser::UpTime();
 
-  // Get current PIDs
-  vector<int> pids = LinuxParser::Pids();
+  vector<int> &pids = pids_;
+  {
+    TickProfiler::Timer timer(profiler_, TickStage::kPids);
+    /* The connector set needs a full scan to start and after overflows */
+    if (events_ == nullptr || !events_->Pids(pids)) {
+      LinuxParser::Pids(pids);
+      if (events_ != nullptr) {
+        events_->Reset(pids);
+      }
+    }
+  }
+
+  {
+    TickProfiler::Timer timer(profiler_, TickStage::kStat);
+    /* Idle processes are only read every few ticks */
+    if (tiered_) {
+      /* procs_running of a fixture was not sampled by this process */
+      int const self =
+          LinuxParser::ProcDirectory() == "/proc/" ? int(getpid()) : 0;
+      scheduler_.Plan(table_, pids, stat_.procsRunning, self, due_);
+    } else {
+      due_.assign(pids.size(), 1);
+    }
 
-  // Create processes
-  for (int pid : pids) {
-    try {
-      processes_.emplace_back(pid);
-    } catch (...) {
-      continue; // Skip failed process creation
+    /* Read /proc/pid/stat in parallel, slot i belongs to pids[i] */
+    stats_.resize(pids.size());
+    read_.resize(pids.size());
+    ios_.resize(io_ ? pids.size() : 0);
+    ioRead_.resize(io_ ? pids.size() : 0);
+    pool_.ParallelFor(pids.size(), [&](unsigned, size_t i) {
+      /* A process may exit between the directory scan and the read */
+      read_[i] =
+          due_[i] && ProcessTable::StatParser::Read(pids[i], stats_[i]);
+      if (io_) {
+        /* The table is not modified until Begin, Find is safe here */
+        ioRead_[i] = kIoSkipped;
+        if (read_[i]) {
+          size_t row = table_.Find(pids[i]);
+          if (row == ProcessTable::kNoRow || !table_.IoDenied(row)) {
+            ioRead_[i] = LinuxParser::ReadProcIo(pids[i], ios_[i]) ? kIoRead
+                         : errno == EACCES                       ? kIoDenied
+                                                                 : kIoSkipped;
+          }
+        }
+      }
+    });
+
+    if (events_ != nullptr) {
+      /* Pids the scan could not read are dropped from the connector set */
+      for (size_t i = 0; i < pids.size(); i++) {
+        if (due_[i] && !read_[i]) {
+          events_->Forget(pids[i]);
+        }
+      }
+      /* Exits whose stat was gone get the counters of the last tick */
+      exitsDropped_ = events_->TakeExits(exited_);
+      for (ExitRecord_t &exit : exited_) {
+        size_t row = table_.Find(exit.pid);
+        if (exit.complete || row == ProcessTable::kNoRow) {
+          continue;
+        }
+        strncpy(exit.comm, table_.Comm(row), sizeof(exit.comm) - 1);
+        exit.cpuSeconds = table_.CpuTime(row);
+        exit.runtimeSeconds =
+            uptime - (float)table_.StartTime(row) / sysconf(_SC_CLK_TCK);
+      }
+    }
+
+    /* pids are ascending, the table merges them in one pass */
+    table_.Begin(elapsed, uptime);
+    for (size_t i = 0; i < pids.size(); i++) {
+      if (read_[i]) {
+        bool io = io_ && ioRead_[i] == kIoRead;
+        table_.Add(pids[i], stats_[i], io ? &ios_[i] : nullptr);
+      } else if (!due_[i]) {
+        table_.Keep(pids[i]);
+      }
     }
+    table_.End();
+
+    /* Flagged after End, Add resets the io state of a reused pid */
+    for (size_t i = 0; i < ioRead_.size(); i++) {
+      if (ioRead_[i] == kIoDenied) {
+        size_t row = table_.Find(pids[i]);
+        if (row != ProcessTable::kNoRow) {
+          table_.DenyIo(row);
+        }
+      }
+    }
+  }
+
+  if (sampler_ != nullptr) {
+    TickProfiler::Timer timer(profiler_, TickStage::kSmaps);
+    sampler_->Sample(table_);
   }
 
-  // Single sort operation
-  std::sort(processes_.begin(), processes_.end());
+  return table_;
+}
 
-  return processes_;
+/**
+ * @brief Returns the rows of the n processes ranked first by the order
+ * of SortBy (CPU utilization by default) in the last Processes()
+ * refresh, highest first
+ *
+ * @param n : Number of processes wanted
+ * @return {const vector<size_t>&} : Rows of the process table, valid
+ * until the next call to Processes()
+ */
+const vector<size_t> &System::TopProcesses(size_t n) {
+  TickProfiler::Timer timer(profiler_, TickStage::kSort);
+  return table_.Top(n, order_);
 }
 
+/**
+ * @brief Returns the processes that exited since the previous
+ * Processes() refresh, only known when events are active
+ *
+ * @return {const vector<ExitRecord_t>&} : Exits in the order they
+ * happened
+ */
+const vector<ExitRecord_t> &System::Exited() const { return exited_; }
+
+/**
+ * @brief Returns the number of exits missing from Exited() because
+ * too many happened within one tick
+ *
+ * @return {uint64_t} : Exits dropped during the last refresh
+ */
+std::uint64_t System::ExitsDropped() const { return exitsDropped_; }
+
+/**
+ * @brief Returns whether pids come from the proc connector
+ *
+ * @return {bool} : false if every tick scans /proc
+ */
+bool System::EventsActive() const { return events_ != nullptr; }
+
+/**
+ * @brief Samples the PSS and USS of the processes after every refresh
+ * of the table, see MemorySampler
+ *
+ * @param budget : CPU time the sampler may spend per tick
+ * @param top : Number of processes with the highest RSS refreshed
+ * every tick
+ */
+void System::SampleMemory(std::chrono::microseconds budget, size_t top) {
+  sampler_ = std::make_unique<MemorySampler>(budget, top);
+}
+
+/**
+ * @brief Returns whether PSS and USS are sampled
+ *
+ * @return {bool} : true after SampleMemory
+ */
+bool System::MemorySampled() const { return sampler_ != nullptr; }
+
+/**
+ * @brief Reads /proc/pid/io along with the stat of each process so the
+ * table holds its I/O rates. Processes whose io file is denied are not
+ * read again until their pid is reused.
+ */
+void System::SampleIo() { io_ = true; }
+
+/**
+ * @brief Returns whether I/O rates are sampled
+ *
+ * @return {bool} : true after SampleIo
+ */
+bool System::IoSampled() const { return io_; }
+
+/**
+ * @brief Sets the order TopProcesses ranks processes by
+ *
+ * @param order : ProcessTable::Order::kIo needs SampleIo
+ */
+void System::SortBy(ProcessTable::Order order) { order_ = order; }
+
 /**
  * @brief Construct a new System:: System object
- * The constructor retrieves the list of process ids
- * and fills the processes_ attributes
+ * The constructor reads the first /proc/stat snapshot and fills
+ * the process table
+ *
+ * @param workers : Number of threads scanning /proc/pid
+ * @param events : Follow forks and exits with the proc connector
+ * instead of listing /proc every tick, full scans are kept if the
+ * connector is unavailable
+ * @param tiered : Read the stat of idle processes less often, see
+ * RefreshScheduler, instead of reading every process every tick
  */
-System::System() {
-  for (int id : LinuxParser::Pids()) {
-    processes_.push_back(Process(id));
+System::System(unsigned workers, bool events, bool tiered)
+    : table_(profiler_), pool_(workers), tiered_(tiered) {
+  if (events) {
+    events_ = std::make_unique<ProcEvents>();
+    if (!events_->Start()) {
+      events_.reset();
+    }
   }
+  Refresh();
+  Processes();
+}
+
+/**
+ * @brief Reads /proc/stat once for this tick and hands the snapshot
+ * to the CPU and the process counters
+ */
+void System::Refresh() {
+  LinuxParser::ReadStatSnapshot(stat_);
+  cpu_.Update(stat_);
 }
 /**
  * @brief Return kernel version provided by the
@@ -84,21 +271,28 @@ float System::MemoryUtilization() {
  */
 std::string System::OperatingSystem() { return LinuxParser::OperatingSystem(); }
 
+/**
+ * @brief Returns the profiler timing the stages of each tick
+ *
+ * @return {TickProfiler&} : Profiler of this system, thread safe
+ */
+TickProfiler &System::Profiler() { return profiler_; }
+
 /**
  * @brief This function returns the number of running processes
- * by calling LinuxParser::RunningProcesses()
+ * from the /proc/stat snapshot of the current tick
  *
  * @return {int} number of running processes
  */
-int System::RunningProcesses() { return LinuxParser::RunningProcesses(); }
+int System::RunningProcesses() { return stat_.procsRunning; }
 
 /**
- * @brief Return the total number of processes by calling
- * LinuxParser::TotalProcesses()
+ * @brief Return the total number of processes from the
+ * /proc/stat snapshot of the current tick
  *
  * @return {int} : The total number of processes as an integer.
  */
-int System::TotalProcesses() { return LinuxParser::TotalProcesses(); }
+int System::TotalProcesses() { return stat_.processes; }
 
 /**
  * @brief Return the system uptime by calling LinuxParser::UpTime()
@@ -0,0 +1,124 @@
+#include "tick_profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::uint64_t readSyscalls();
+
+TickProfiler::TickProfiler() : lastSyscalls_(readSyscalls()) {}
+
+/**
+ * @brief Adds time spent in a stage to the current tick
+ *
+ * @param stage : Stage measured
+ * @param ns : Wall time in nanoseconds
+ */
+void TickProfiler::Add(TickStage stage, std::int64_t ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_[static_cast<std::size_t>(stage)] += ns;
+}
+
+/**
+ * @brief Closes the current tick and pushes its measures into the
+ * rolling windows
+ */
+void TickProfiler::EndTick() {
+  /* Read outside the lock, the counter includes its own read */
+  std::uint64_t syscalls = readSyscalls();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::size_t i = 0; i < kTickStages; i++) {
+    stages_[i].Push(current_[i]);
+    current_[i] = 0;
+  }
+  syscalls_.Push(syscalls - lastSyscalls_);
+  lastSyscalls_ = syscalls;
+}
+
+/**
+ * @brief Returns the last tick and the percentiles of the window
+ *
+ * @return {TickProfile_t} : Profile of the last kWindow ticks
+ */
+TickProfile_t TickProfiler::Profile() const {
+  TickProfile_t profile;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::size_t i = 0; i < kTickStages; i++) {
+    profile.stages[i] = stages_[i].Summary();
+  }
+  profile.syscalls = syscalls_.Summary();
+  return profile;
+}
+
+/**
+ * @brief Returns the short name of a stage
+ *
+ * @param stage : Stage
+ * @return {const char *} : "pids", "stat", "status", "user", "sort"
+ * or "render"
+ */
+const char *TickProfiler::StageName(TickStage stage) {
+  static const char *const kNames[kTickStages]{
+      "pids", "stat", "status", "user", "smaps", "sort", "render"};
+  return kNames[static_cast<std::size_t>(stage)];
+}
+
+void TickProfiler::Window_t::Push(std::int64_t value) {
+  values[count % kWindow] = value;
+  count++;
+}
+
+Percentiles_t TickProfiler::Window_t::Summary() const {
+  Percentiles_t summary;
+  std::size_t const size = std::min(count, kWindow);
+  if (size == 0) {
+    return summary;
+  }
+  summary.last = values[(count - 1) % kWindow];
+
+  /* Nearest rank on a copy, the ring keeps its order */
+  std::array<std::int64_t, kWindow> sorted;
+  std::copy(values.begin(), values.begin() + size, sorted.begin());
+  auto end = sorted.begin() + size;
+  auto p50 = sorted.begin() + (size - 1) / 2;
+  auto p99 = sorted.begin() + (size * 99 + 99) / 100 - 1;
+  std::nth_element(sorted.begin(), p99, end);
+  summary.p99 = *p99;
+  std::nth_element(sorted.begin(), p50, p99);
+  summary.p50 = *p50;
+  summary.max = *std::max_element(p99, end);
+  return summary;
+}
+
+/**
+ * @brief Returns syscr + syscw of this process
+ * Always read from the real /proc, not from LinuxParser::ProcDirectory
+ *
+ * @return {uint64_t} : Read and write class syscalls made so far, 0 if
+ * /proc/self/io cannot be read
+ */
+static std::uint64_t readSyscalls() {
+  char buffer[512];
+  int fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return 0;
+  }
+  ssize_t size = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (size <= 0) {
+    return 0;
+  }
+  buffer[size] = '\0';
+
+  std::uint64_t total = 0;
+  for (const char *key : {"syscr: ", "syscw: "}) {
+    const char *field = strstr(buffer, key);
+    if (field != nullptr) {
+      total += strtoull(field + strlen(key), nullptr, 10);
+    }
+  }
+  return total;
+}
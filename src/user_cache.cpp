@@ -0,0 +1,211 @@
+#include "user_cache.h"
+#include "linux_parser.h"
+#include <charconv>
+#include <fstream>
+#include <pwd.h>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Hashes a uid into a slot index of a table of the given capacity
+ *
+ * @param uid : User ID
+ * @param capacity : Number of slots, a power of 2
+ * @return {size_t} : Index of the first slot to probe
+ */
+static size_t slotOf(uid_t uid, size_t capacity) {
+  /* Fibonacci hashing spreads consecutive uids over the table */
+  return (static_cast<uint64_t>(uid) * 0x9E3779B97F4A7C15ull >> 32) &
+         (capacity - 1);
+}
+
+/**
+ * @brief Returns the table shared by the whole process
+ *
+ * @return {UserCache&} : The process-wide instance
+ */
+UserCache &UserCache::Instance() {
+  static UserCache instance;
+  return instance;
+}
+
+/**
+ * @brief Returns the user name associated with the uid
+ * If no name can be found the uid itself is returned as a string.
+ *
+ * @param uid : User ID
+ * @return {string} : User name associated with the uid
+ */
+string UserCache::Lookup(uid_t uid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Revalidate();
+    const Slot_t *slot = Find(uid);
+    if (slot != nullptr) {
+      return names_[slot->name];
+    }
+  }
+
+  /* Not in /etc/passwd, ask NSS once and remember the answer. NSS may
+     go to the network (LDAP): the lock is not held meanwhile so other
+     lookups are not blocked */
+  string name = Resolve(uid);
+  std::lock_guard<std::mutex> lock(mutex_);
+  /* Another thread may have resolved it first, its entry wins */
+  Insert(uid, std::move(name));
+  return names_[Find(uid)->name];
+}
+
+/**
+ * @brief Rebuilds the table if /etc/passwd changed since it was loaded
+ * The file is checked at most once per kRecheckPeriod.
+ */
+void UserCache::Revalidate() {
+  auto now = std::chrono::steady_clock::now();
+  if (loaded_ && now - lastCheck_ < kRecheckPeriod) {
+    return;
+  }
+  lastCheck_ = now;
+
+  struct stat info = {};
+  if (stat(LinuxParser::PasswordPath().c_str(), &info) != 0) {
+    /* Keep what we have, NSS still resolves missing uids */
+    loaded_ = true;
+    return;
+  }
+
+  bool changed = !loaded_ || info.st_dev != device_ ||
+                 info.st_ino != inode_ || info.st_size != size_ ||
+                 info.st_mtim.tv_sec != mtime_.tv_sec ||
+                 info.st_mtim.tv_nsec != mtime_.tv_nsec;
+  if (changed) {
+    device_ = info.st_dev;
+    inode_ = info.st_ino;
+    size_ = info.st_size;
+    mtime_ = info.st_mtim;
+    Load();
+  }
+  loaded_ = true;
+}
+
+/**
+ * @brief Clears the table and fills it from /etc/passwd
+ * Each line is name:password:uid:gid:gecos:home:shell
+ */
+void UserCache::Load() {
+  slots_.assign(64, Slot_t{});
+  names_.clear();
+
+  std::ifstream passwdStream(LinuxParser::PasswordPath());
+  string line;
+  while (std::getline(passwdStream, line)) {
+    string_view fields(line);
+    size_t nameEnd = fields.find(':');
+    size_t passwordEnd = fields.find(':', nameEnd + 1);
+    if (nameEnd == string_view::npos || passwordEnd == string_view::npos) {
+      continue;
+    }
+    const char *first = line.data() + passwordEnd + 1;
+    const char *last = line.data() + line.size();
+    uid_t uid = 0;
+    if (std::from_chars(first, last, uid).ec == std::errc()) {
+      Insert(uid, string(fields.substr(0, nameEnd)));
+    }
+  }
+}
+
+/**
+ * @brief Resolves a uid missing from /etc/passwd through NSS
+ *
+ * @param uid : User ID
+ * @return {string} : User name, or the uid as a string if unknown
+ */
+string UserCache::Resolve(uid_t uid) {
+  long size = sysconf(_SC_GETPW_R_SIZE_MAX);
+  std::vector<char> buffer(size > 0 ? size : 16384);
+  struct passwd entry;
+  struct passwd *result = nullptr;
+
+  if (getpwuid_r(uid, &entry, buffer.data(), buffer.size(), &result) == 0 &&
+      result != nullptr) {
+    return result->pw_name;
+  }
+  return std::to_string(uid);
+}
+
+/**
+ * @brief Adds the name of a uid, the first entry of a uid wins
+ *
+ * @param uid : User ID
+ * @param name : User name
+ */
+void UserCache::Insert(uid_t uid, string name) {
+  if (slots_.empty()) {
+    slots_.assign(64, Slot_t{});
+  }
+  /* Keep the load factor under 1/2 so probes stay short */
+  if ((names_.size() + 1) * 2 > slots_.size()) {
+    Grow();
+  }
+
+  size_t mask = slots_.size() - 1;
+  for (size_t i = slotOf(uid, slots_.size());; i = (i + 1) & mask) {
+    Slot_t &slot = slots_[i];
+    if (!slot.used) {
+      slot.uid = uid;
+      slot.used = true;
+      slot.name = names_.size();
+      names_.push_back(std::move(name));
+      return;
+    }
+    if (slot.uid == uid) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Finds the slot holding the uid
+ *
+ * @param uid : User ID
+ * @return {const Slot_t*} : The slot or nullptr if the uid is not cached
+ */
+const UserCache::Slot_t *UserCache::Find(uid_t uid) const {
+  if (slots_.empty()) {
+    return nullptr;
+  }
+  size_t mask = slots_.size() - 1;
+  for (size_t i = slotOf(uid, slots_.size());; i = (i + 1) & mask) {
+    const Slot_t &slot = slots_[i];
+    if (!slot.used) {
+      return nullptr;
+    }
+    if (slot.uid == uid) {
+      return &slot;
+    }
+  }
+}
+
+/**
+ * @brief Doubles the capacity of the table and rehashes every entry
+ */
+void UserCache::Grow() {
+  std::vector<Slot_t> slots(slots_.size() * 2);
+  size_t mask = slots.size() - 1;
+
+  for (const Slot_t &old : slots_) {
+    if (!old.used) {
+      continue;
+    }
+    size_t i = slotOf(old.uid, slots.size());
+    while (slots[i].used) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = old;
+  }
+  slots_.swap(slots);
+}
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fixture.h"
+
+int main(int argc, char *argv[]) {
+  Fixture::Options_t options;
+  const char *root = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(argv[i], "--processes") == 0 && value != nullptr) {
+      options.processes = strtoul(value, nullptr, 10);
+      i++;
+    } else if (strcmp(argv[i], "--cores") == 0 && value != nullptr) {
+      options.cores = std::max(1l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(argv[i], "--users") == 0 && value != nullptr) {
+      options.users = std::max(1l, strtol(value, nullptr, 10));
+      i++;
+    } else if (strcmp(argv[i], "--seed") == 0 && value != nullptr) {
+      options.seed = strtoul(value, nullptr, 10);
+      i++;
+    } else if (root == nullptr && argv[i][0] != '-') {
+      root = argv[i];
+    } else {
+      root = nullptr;
+      break;
+    }
+  }
+
+  if (root == nullptr) {
+    fprintf(stderr,
+            "usage: %s ROOT [--processes N] [--cores N] [--users N] "
+            "[--seed N]\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (!Fixture::Generate(root, options)) {
+    perror(root);
+    return EXIT_FAILURE;
+  }
+  printf("run: monitor --proc-root %s/proc --passwd %s/etc/passwd "
+         "--os-release %s/etc/os-release\n",
+         root, root, root);
+  return EXIT_SUCCESS;
+}